@@ -0,0 +1,248 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: annealing.cpp
+// Description: Implementation of the simulated annealing mapping optimizer
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <thread>
+#include "utils.h"
+#include "annealing.h"
+
+// Ratio between the highest and the lowest temperature
+#define PT_TEMPERATURE_RANGE 1000.0
+
+// Number of Metropolis steps per qubit done by each replica in an
+// epoch
+#define PT_MOVES_PER_QUBIT 20
+
+// ----------------------------------------------------------------------
+MappingCostModel::MappingCostModel(const InteractionGraph& graph_ref, const NoC& noc,
+				   const int ncores, const double t_quantum, const int volume)
+  : graph(graph_ref)
+{
+  double t_hop = noc.getTransferTime(volume);
+
+  core_cost.assign(ncores, vector<double>(ncores, 0.0));
+  for (int a = 0; a < ncores; a++)
+    for (int b = 0; b < ncores; b++)
+      if (a != b)
+	core_cost[a][b] = t_quantum + noc.getHopDistance(a, b) * t_hop;
+}
+
+// ----------------------------------------------------------------------
+double MappingCostModel::cost(const vector<int>& q2c) const
+{
+  double c = 0.0;
+
+  for (int v = 0; v < graph.nvertices; v++)
+    for (const auto& e : graph.adj[v])
+      if (v < e.first)
+	c += e.second * core_cost[q2c[v]][q2c[e.first]];
+
+  return c;
+}
+
+// ----------------------------------------------------------------------
+double MappingCostModel::moveDelta(const vector<int>& q2c, const int qb, const int dst) const
+{
+  int src = q2c[qb];
+  double delta = 0.0;
+
+  for (const auto& e : graph.adj[qb])
+    {
+      int core = q2c[e.first];
+      delta += e.second * (core_cost[dst][core] - core_cost[src][core]);
+    }
+
+  return delta;
+}
+
+// ----------------------------------------------------------------------
+double MappingCostModel::swapDelta(const vector<int>& q2c, const int qa, const int qb) const
+{
+  int ca = q2c[qa];
+  int cb = q2c[qb];
+  double delta = 0.0;
+  double w_ab = 0.0;
+
+  for (const auto& e : graph.adj[qa])
+    {
+      if (e.first == qb)
+	w_ab = e.second;
+      int core = q2c[e.first];
+      delta += e.second * (core_cost[cb][core] - core_cost[ca][core]);
+    }
+
+  for (const auto& e : graph.adj[qb])
+    {
+      int core = q2c[e.first];
+      delta += e.second * (core_cost[ca][core] - core_cost[cb][core]);
+    }
+
+  // The edge between qa and qb has been accounted as if the other
+  // qubit did not move, while after the swap it still connects cb
+  // and ca
+  delta += w_ab * (core_cost[ca][cb] + core_cost[cb][ca]);
+
+  return delta;
+}
+
+// ----------------------------------------------------------------------
+double AnnealingOptimizer::estimateDeltaScale(const vector<int>& q2c, mt19937& gen)
+{
+  int nqubits = q2c.size();
+  uniform_int_distribution<int> rnd_qubit(0, nqubits - 1);
+  double sum = 0.0;
+  int samples = 0;
+
+  for (int i = 0; i < 1000; i++)
+    {
+      int qa = rnd_qubit(gen);
+      int qb = rnd_qubit(gen);
+      if (q2c[qa] == q2c[qb])
+	continue;
+
+      double d = fabs(model.swapDelta(q2c, qa, qb));
+      if (d > 0.0)
+	{
+	  sum += d;
+	  samples++;
+	}
+    }
+
+  return (samples == 0) ? 1.0 : sum / samples;
+}
+
+// ----------------------------------------------------------------------
+void AnnealingOptimizer::walk(AnnealingReplica& r, const long nmoves)
+{
+  int nqubits = r.q2c.size();
+  uniform_int_distribution<int> rnd_qubit(0, nqubits - 1);
+  uniform_int_distribution<int> rnd_core(0, ncores - 1);
+  uniform_real_distribution<double> rnd_real(0.0, 1.0);
+
+  for (long i = 0; i < nmoves; i++)
+    {
+      int qa = rnd_qubit(r.gen);
+      int ca = r.q2c[qa];
+      bool swap_move = (rnd_real(r.gen) < 0.5);
+
+      int qb = -1, cb;
+      double delta;
+      if (swap_move)
+	{
+	  qb = rnd_qubit(r.gen);
+	  cb = r.q2c[qb];
+	  if (ca == cb)
+	    continue;
+	  delta = model.swapDelta(r.q2c, qa, qb);
+	}
+      else
+	{
+	  cb = rnd_core(r.gen);
+	  if (ca == cb || r.loads[cb] >= max_load)
+	    continue;
+	  delta = model.moveDelta(r.q2c, qa, cb);
+	}
+
+      if (delta <= 0.0 || rnd_real(r.gen) < exp(-delta / r.temperature))
+	{
+	  r.q2c[qa] = cb;
+	  if (swap_move)
+	    r.q2c[qb] = ca;
+	  else
+	    {
+	      r.loads[ca]--;
+	      r.loads[cb]++;
+	    }
+	  r.cost += delta;
+	  r.accepted_moves++;
+	}
+    }
+}
+
+// ----------------------------------------------------------------------
+vector<int> AnnealingOptimizer::optimize(const vector<int>& initial, const double time_budget,
+					 const unsigned seed)
+{
+  chrono::high_resolution_clock::time_point chrono_start;
+  startChrono(chrono_start);
+
+  vector<int> loads(ncores, 0);
+  for (int c : initial)
+    loads[c]++;
+
+  initial_cost = model.cost(initial);
+  best_cost = initial_cost;
+  vector<int> best = initial;
+
+  if (initial.size() < 2 || ncores < 2)
+    return best;
+
+  // Temperatures are geometrically spaced between t_max and
+  // t_max/PT_TEMPERATURE_RANGE
+  mt19937 gen(seed);
+  double t_max = estimateDeltaScale(initial, gen);
+  vector<AnnealingReplica> replicas(nreplicas);
+  for (int i = 0; i < nreplicas; i++)
+    {
+      AnnealingReplica& r = replicas[i];
+      r.q2c = initial;
+      r.loads = loads;
+      r.cost = initial_cost;
+      r.temperature = (nreplicas == 1) ? t_max / PT_TEMPERATURE_RANGE :
+	t_max * pow(PT_TEMPERATURE_RANGE, -(double)i / (nreplicas - 1));
+      r.gen.seed(seed + i);
+      r.accepted_moves = 0;
+    }
+
+  long nmoves = (long)PT_MOVES_PER_QUBIT * initial.size();
+  uniform_real_distribution<double> rnd_real(0.0, 1.0);
+  epochs = 0;
+  exchanges = 0;
+
+  while (stopChrono(chrono_start) < time_budget)
+    {
+      vector<thread> threads;
+      for (int i = 0; i < nreplicas; i++)
+	threads.push_back(thread(&AnnealingOptimizer::walk, this, ref(replicas[i]), nmoves));
+      for (auto& t : threads)
+	t.join();
+      epochs++;
+
+      // Exchange the configurations of adjacent temperatures
+      for (int i = 0; i + 1 < nreplicas; i++)
+	{
+	  AnnealingReplica& ri = replicas[i];
+	  AnnealingReplica& rj = replicas[i+1];
+	  double p = exp((ri.cost - rj.cost) * (1.0/ri.temperature - 1.0/rj.temperature));
+	  if (p >= 1.0 || rnd_real(gen) < p)
+	    {
+	      swap(ri.q2c, rj.q2c);
+	      swap(ri.loads, rj.loads);
+	      swap(ri.cost, rj.cost);
+	      exchanges++;
+	    }
+	}
+
+      for (const auto& r : replicas)
+	if (r.cost < best_cost)
+	  {
+	    // Recompute the cost from scratch to avoid the accumulation
+	    // of rounding errors of the incremental updates
+	    best_cost = model.cost(r.q2c);
+	    best = r.q2c;
+	  }
+    }
+
+  accepted_moves = 0;
+  for (const auto& r : replicas)
+    accepted_moves += r.accepted_moves;
+
+  return best;
+}
@@ -0,0 +1,90 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: annealing.h
+// Description: Declaration of the simulated annealing mapping optimizer
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __ANNEALING_H__
+#define __ANNEALING_H__
+
+#include <vector>
+#include <random>
+#include "partitioning.h"
+#include "noc.h"
+
+using namespace std;
+
+// Modeled cost of a mapping: every interaction of weight w between
+// two qubits mapped on cores a and b costs w * core_cost[a][b], where
+// core_cost[a][b] is the time of a teleportation from a to b (fixed
+// quantum part plus the classical transfer over the hops between a
+// and b). The cost of a swap or of a move is computed incrementally
+// by visiting the neighbours of the involved qubits only.
+struct MappingCostModel
+{
+  const InteractionGraph& graph;
+  vector<vector<double> > core_cost;
+
+  MappingCostModel(const InteractionGraph& graph_ref, const NoC& noc, const int ncores,
+		   const double t_quantum, const int volume);
+
+  double cost(const vector<int>& q2c) const;
+
+  // Cost variation if qubit qb is moved to core dst
+  double moveDelta(const vector<int>& q2c, const int qb, const int dst) const;
+
+  // Cost variation if the cores of qubits qa and qb are swapped
+  double swapDelta(const vector<int>& q2c, const int qa, const int qb) const;
+};
+
+// Replica of the parallel tempering
+struct AnnealingReplica
+{
+  vector<int> q2c;
+  vector<int> loads;
+  double      cost;
+  double      temperature;
+  mt19937     gen;
+  long        accepted_moves;
+};
+
+// Parallel tempering: each replica runs a Metropolis walk at its own
+// temperature in a separate thread. After every epoch, replicas at
+// adjacent temperatures exchange their configurations with the usual
+// acceptance probability. The search stops when the time budget is
+// exhausted.
+struct AnnealingOptimizer
+{
+  const MappingCostModel& model;
+  int    ncores;
+  int    max_load; // max number of qubits per core
+  int    nreplicas;
+
+  // Statistics
+  double initial_cost;
+  double best_cost;
+  long   epochs;
+  long   exchanges;
+  long   accepted_moves;
+
+  AnnealingOptimizer(const MappingCostModel& model_ref, const int _ncores,
+		     const int _max_load, const int _nreplicas)
+    : model(model_ref), ncores(_ncores), max_load(_max_load), nreplicas(_nreplicas),
+      initial_cost(0.0), best_cost(0.0), epochs(0), exchanges(0), accepted_moves(0) {}
+
+  // Returns the best mapping found starting from initial
+  vector<int> optimize(const vector<int>& initial, const double time_budget,
+		       const unsigned seed);
+
+  // Runs nmoves Metropolis steps on replica r (swaps or moves to
+  // cores with free capacity)
+  void walk(AnnealingReplica& r, const long nmoves);
+
+  // Average absolute cost variation of random moves, used to scale
+  // the temperatures
+  double estimateDeltaScale(const vector<int>& q2c, mt19937& gen);
+};
+
+#endif
@@ -8,6 +8,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <numeric>
 #include <sstream>
 #include <yaml-cpp/yaml.h>
 #include "utils.h"
@@ -21,13 +23,47 @@ void Architecture::display() const
        << IND << "number_of_cores: " << number_of_cores << endl
        << IND << "qubits_per_core: " << qubits_per_core << endl
        << IND << "total_physical_qubits: " << total_physical_qubits << endl
-       << IND << "ltm_ports: " << ltm_ports << endl;
+       << IND << "ltm_ports: " << ltm_ports << endl
+       << IND << "comm_qubits: " << comm_qubits << " # per core (0 = ancillas in the data qubits)" << endl
+       << IND << "comm_overflow_to_data: " << (comm_overflow_to_data ? "true" : "false") << endl;
+
+  cout << IND << "coupling_graph: " << coupling_graph;
+  if (coupling_graph == COUPLING_FULL)
+    cout << " # all to all" << endl;
+  else if (coupling_graph == COUPLING_LINEAR)
+    cout << " # linear" << endl;
+  else if (coupling_graph == COUPLING_GRID)
+    cout << " # grid" << endl;
+  else if (coupling_graph == COUPLING_HEAVY_HEX)
+    cout << " # heavy-hex" << endl;
+  else
+    cout << " # ??\?" << endl;
+
+  if (isHeterogeneous())
+    {
+      cout << IND << "core_overrides:" << endl;
+      for (const auto& co : core_overrides)
+	{
+	  int c = getOverriddenCore(co);
+	  cout << IND << IND << "'core " << c << "': {qubits: " << core_qubits[c]
+	       << ", ltm_ports: " << core_ltm_ports[c]
+	       << ", gate_delay_scale: " << co.gate_delay_scale << ", gate_delays: {";
+	  for (auto it = co.gate_delays.begin(); it != co.gate_delays.end(); ++it)
+	    cout << (it == co.gate_delays.begin() ? "" : ", ") << it->first << ": " << it->second;
+	  cout << "}}" << endl;
+	}
+    }
 
   cout << IND << "teleportation_type: " << teleportation_type;
   if (teleportation_type == TP_TYPE_A2A)
     cout << " # all to all" << endl;
   else if (teleportation_type == TP_TYPE_MESH)
     cout << " # mesh" << endl;
+  else if (teleportation_type == TP_TYPE_SWAP)
+    cout << " # mesh with entanglement swapping" << endl;
+  else if (teleportation_type == TP_TYPE_SHUTTLE)
+    cout << " # shuttling" << endl
+	 << IND << "shuttle_capacity: " << noc.shuttle_capacity << " # ions per segment" << endl;
   else 
     cout << " # ??\?" << endl;
 
@@ -36,8 +72,57 @@ void Architecture::display() const
     cout << " # load independent" << endl;
   else if (dst_selection_mode == DST_SEL_LOAD_AWARE)
     cout << " # load aware" << endl;
+  else if (dst_selection_mode == DST_SEL_LOOKAHEAD)
+    cout << " # lookahead" << endl;
+  else if (dst_selection_mode == DST_SEL_COST)
+    cout << " # cost" << endl;
+  else
+    cout << " # ??\?" << endl;
+
+  if (dst_selection_mode == DST_SEL_COST)
+    cout << IND << "dst_cost_hop_weight: " << dst_cost_hop_weight << endl
+	 << IND << "dst_cost_port_weight: " << dst_cost_port_weight << endl
+	 << IND << "dst_cost_load_weight: " << dst_cost_load_weight << endl
+	 << IND << "dst_cost_ancilla_weight: " << dst_cost_ancilla_weight << endl;
+
+  cout << IND << "eviction_policy: " << eviction_policy;
+  if (eviction_policy == EVICT_NONE)
+    cout << " # none" << endl;
+  else if (eviction_policy == EVICT_LRU)
+    cout << " # lru" << endl;
+  else if (eviction_policy == EVICT_BELADY)
+    cout << " # belady" << endl;
+  else if (eviction_policy == EVICT_NEIGHBOR)
+    cout << " # neighbor" << endl;
+  else
+    cout << " # ??\?" << endl;
+
+  cout << IND << "packing_policy: " << packing_policy;
+  if (packing_policy == PACK_GREEDY)
+    cout << " # greedy" << endl;
+  else if (packing_policy == PACK_MATCHING)
+    cout << " # matching" << endl;
+  else if (packing_policy == PACK_CRITICAL_FIRST)
+    cout << " # critical first" << endl;
   else
     cout << " # ??\?" << endl;
+
+  cout << IND << "remote_gate_mode: " << remote_gate_mode;
+  if (remote_gate_mode == REMOTE_TELEDATA)
+    cout << " # teledata" << endl;
+  else if (remote_gate_mode == REMOTE_TELEGATE)
+    cout << " # telegate" << endl;
+  else if (remote_gate_mode == REMOTE_ADAPTIVE)
+    cout << " # adaptive" << endl;
+  else
+    cout << " # ??\?" << endl;
+
+  if (dst_selection_mode == DST_SEL_LOOKAHEAD || eviction_policy == EVICT_NEIGHBOR ||
+      remote_gate_mode == REMOTE_ADAPTIVE)
+    cout << IND << "lookahead_slices: " << lookahead_slices << endl
+	 << IND << "lookahead_discount: " << lookahead_discount << endl
+	 << IND << "lookahead_load_weight: " << lookahead_load_weight << endl
+	 << IND << "lookahead_hop_weight: " << lookahead_hop_weight << endl;
   
   
   cout << IND << "mapping_type: " << mapping_type;
@@ -45,9 +130,31 @@ void Architecture::display() const
     cout << " # random" << endl;
   else if (mapping_type == MAP_SEQUENTIAL)
     cout << " # sequential" << endl;
+  else if (mapping_type == MAP_PARTITION)
+    cout << " # partition" << endl;
+  else if (mapping_type == MAP_FILE)
+    cout << " # file" << endl;
   else
     cout << " # ??\?" << endl;
 
+  if (mapping_type == MAP_FILE)
+    cout << IND << "mapping_file: '" << mapping_file << "'" << endl;
+
+  if (!mapping_output_file.empty())
+    cout << IND << "mapping_output_file: '" << mapping_output_file << "'" << endl;
+
+  if (mapping_type == MAP_PARTITION)
+    cout << IND << "partition_decay: " << partition_decay << endl
+	 << IND << "partition_imbalance: " << partition_imbalance << endl
+	 << IND << "partition_mesh_aware: " << (partition_mesh_aware ? "true" : "false") << endl;
+
+  cout << IND << "rebalance_interval: " << rebalance_interval << endl
+       << IND << "rebalance_threshold: " << rebalance_threshold << endl;
+  cout << IND << "prefetch_slices: " << prefetch_slices << endl;
+
+  cout << IND << "icache_capacity: " << icache_capacity << " # bits per core (0 = disabled)" << endl;
+
+  memory_interfaces.display();
   noc.display();
   cores.display();
 }
@@ -60,14 +167,78 @@ bool Architecture::readFromFile(const string& file_name)
   result &= getOrFail<int>(config, "mesh_x", file_name, noc.mesh_x);
   result &= getOrFail<int>(config, "mesh_y", file_name, noc.mesh_y);
   result &= getOrFail<int>(config, "link_width", file_name, noc.link_width);
+  result &= getOrDefault<int>(config, "routing_algorithm", file_name, noc.routing_algorithm, ROUTING_XY);
+  result &= getOrDefault<int>(config, "topology", file_name, noc.topology_type, TOPO_MESH);
+  result &= getOrDefault<int>(config, "flow_control", file_name, noc.flow_control, FLOW_STORE_AND_FORWARD);
+  result &= getOrDefault<int>(config, "router_pipeline", file_name, noc.router_pipeline, 1);
+  result &= getOrDefault<int>(config, "buffer_depth", file_name, noc.buffer_depth, 4);
+  result &= getOrDefault<int>(config, "virtual_channels", file_name, noc.virtual_channels, 2);
+  result &= getOrDefault<bool>(config, "coalescing", file_name, noc.coalescing, false);
+  result &= getOrDefault<int>(config, "packet_header_bits", file_name, noc.packet_header_bits, 0);
+  result &= getOrDefault<int>(config, "max_packet_bits", file_name, noc.max_packet_bits, 0);
+  result &= getOrDefault<bool>(config, "multicast", file_name, noc.multicast, false);
+  result &= getOrDefault<int>(config, "qlink_channels", file_name, noc.qlink_channels, 0);
+  result &= getOrDefault<int>(config, "shuttle_capacity", file_name, noc.shuttle_capacity, 1);
+  result &= getOrDefault<int>(config, "hybrid_mode", file_name, noc.hybrid_mode, HYBRID_OFF);
+  result &= getOrDefault<int>(config, "hybrid_hop_threshold", file_name, noc.hybrid_hop_threshold, 3);
+  result &= getOrDefault<int>(config, "hybrid_volume_threshold", file_name,
+			      noc.hybrid_volume_threshold, 64);
+  result &= getOrDefault<string>(config, "topology_file", file_name, noc.topology_file, "");
+  result &= getOrDefault<int>(config, "concentration", file_name, noc.concentration, 4);
+  result &= getOrDefault<int>(config, "global_link_latency", file_name, noc.global_link_latency, 2);
   result &= getOrFail<int>(config, "qubits_per_core", file_name, qubits_per_core);
   result &= getOrFail<int>(config, "ltm_ports", file_name, ltm_ports);
+  result &= getOrDefault<int>(config, "comm_qubits", file_name, comm_qubits, 0);
+  result &= getOrDefault<bool>(config, "comm_overflow_to_data", file_name, comm_overflow_to_data, false);
+  result &= getOrDefault<int>(config, "coupling_graph", file_name, coupling_graph, COUPLING_FULL);
   result &= getOrFail<int>(config, "radio_channels", file_name, noc.radio_channels);
   result &= getOrFail<bool>(config, "wireless_enabled", file_name, noc.winoc);
   result &= getOrFail<int>(config, "teleportation_type", file_name, teleportation_type);
   result &= getOrFail<int>(config, "wireless_mac", file_name, noc.wireless_mac);
   result &= getOrFail<int>(config, "dst_selection_mode", file_name, dst_selection_mode);
+  result &= getOrDefault<int>(config, "eviction_policy", file_name, eviction_policy, EVICT_NONE);
+  result &= getOrDefault<int>(config, "packing_policy", file_name, packing_policy, PACK_GREEDY);
+  result &= getOrDefault<int>(config, "remote_gate_mode", file_name, remote_gate_mode, REMOTE_TELEDATA);
   result &= getOrFail<int>(config, "mapping_type", file_name, mapping_type);
+  result &= getOrDefault<string>(config, "mapping_file", file_name, mapping_file, "");
+  result &= getOrDefault<string>(config, "mapping_output_file", file_name, mapping_output_file, "");
+  result &= getOrDefault<double>(config, "partition_decay", file_name, partition_decay, 0.0);
+  result &= getOrDefault<double>(config, "partition_imbalance", file_name, partition_imbalance, 0.1);
+  result &= getOrDefault<bool>(config, "partition_mesh_aware", file_name, partition_mesh_aware, true);
+  result &= getOrDefault<int>(config, "lookahead_slices", file_name, lookahead_slices, 8);
+  result &= getOrDefault<double>(config, "lookahead_discount", file_name, lookahead_discount, 0.8);
+  result &= getOrDefault<double>(config, "lookahead_load_weight", file_name, lookahead_load_weight, 8.0);
+  result &= getOrDefault<double>(config, "lookahead_hop_weight", file_name, lookahead_hop_weight, 0.1);
+  result &= getOrDefault<double>(config, "dst_cost_hop_weight", file_name, dst_cost_hop_weight, 1.0);
+  result &= getOrDefault<double>(config, "dst_cost_port_weight", file_name, dst_cost_port_weight, 4.0);
+  result &= getOrDefault<double>(config, "dst_cost_load_weight", file_name, dst_cost_load_weight, 4.0);
+  result &= getOrDefault<double>(config, "dst_cost_ancilla_weight", file_name, dst_cost_ancilla_weight, 1.0);
+  result &= getOrDefault<int>(config, "rebalance_interval", file_name, rebalance_interval, 0);
+  result &= getOrDefault<double>(config, "rebalance_threshold", file_name, rebalance_threshold, 0.0);
+  result &= getOrDefault<int>(config, "prefetch_slices", file_name, prefetch_slices, 0);
+  result &= getOrDefault<int>(config, "memory_interfaces", file_name, memory_interfaces.number, 1);
+  result &= getOrDefault<int>(config, "mi_placement", file_name, memory_interfaces.placement,
+			      MI_PLACE_CORNER);
+  result &= getOrDefault<vector<int> >(config, "mi_cores", file_name, memory_interfaces.core_list,
+				       vector<int>());
+  result &= getOrDefault<double>(config, "mi_bandwidth", file_name, memory_interfaces.bandwidth, 0.0);
+  result &= getOrDefault<int>(config, "mi_assignment", file_name, memory_interfaces.assignment,
+			      MI_ASSIGN_NEAREST);
+  result &= getOrDefault<int>(config, "icache_capacity", file_name, icache_capacity, 0);
+
+  core_overrides.clear();
+  for (const auto& node : config["core_overrides"])
+    {
+      CoreOverride co;
+      result &= getOrDefault<int>(node, "core", file_name, co.core, -1);
+      result &= getOrDefault<vector<int> >(node, "location", file_name, co.location, vector<int>());
+      result &= getOrDefault<int>(node, "qubits", file_name, co.qubits, 0);
+      result &= getOrDefault<int>(node, "ltm_ports", file_name, co.ltm_ports, 0);
+      result &= getOrDefault<double>(node, "gate_delay_scale", file_name, co.gate_delay_scale, 1.0);
+      result &= getOrDefault<map<string,double> >(node, "gate_delays", file_name, co.gate_delays,
+						  map<string,double>());
+      core_overrides.push_back(co);
+    }
   
   computeDerivedVariables();
   
@@ -76,10 +247,89 @@ bool Architecture::readFromFile(const string& file_name)
 
 void Architecture::computeDerivedVariables()
 {
-  number_of_cores = noc.mesh_x * noc.mesh_y;
-  total_physical_qubits = number_of_cores * qubits_per_core;
+  noc.buildTopology();
+  number_of_cores = noc.number_of_cores;
+
+  // With bounded buffers the routes must be deadlock-free
+  if (noc.flow_control == FLOW_WORMHOLE)
+    {
+      if (noc.buffer_depth < 1)
+	FATAL("buffer_depth must be at least 1 with the wormhole flow control");
+      if (noc.virtual_channels < noc.getVCClasses())
+	FATAL("the routes of the topology need at least " + to_string(noc.getVCClasses()) +
+	      " virtual_channels with the wormhole flow control");
+      if (noc.topology_type != TOPO_MESH && noc.topology.hasCyclicDependencies())
+	FATAL("the routes of the topology can deadlock with the wormhole flow control");
+    }
 
-  noc.qubit_addr_bits = ceil(log2(qubits_per_core * number_of_cores));  
+  core_qubits.assign(number_of_cores, qubits_per_core);
+  core_ltm_ports.assign(number_of_cores, ltm_ports);
+  for (const auto& co : core_overrides)
+    {
+      int c = getOverriddenCore(co);
+      if (co.qubits > 0)
+	core_qubits[c] = co.qubits;
+      if (co.ltm_ports > 0)
+	core_ltm_ports[c] = co.ltm_ports;
+    }
+  total_physical_qubits = accumulate(core_qubits.begin(), core_qubits.end(), 0);
+
+  noc.qubit_addr_bits = ceil(log2(total_physical_qubits));  
+
+  memory_interfaces.build(noc);
+}
+
+int Architecture::getOverriddenCore(const CoreOverride& co) const
+{
+  int c = co.core;
+
+  if (c == -1)
+    {
+      if (co.location.size() != 2)
+	FATAL("core_overrides: each override needs a core or a location [x, y]");
+      if (noc.topology_type != TOPO_MESH && noc.topology_type != TOPO_TORUS)
+	FATAL("core_overrides: location requires a mesh or torus topology");
+      if (co.location[0] < 0 || co.location[0] >= noc.mesh_x ||
+	  co.location[1] < 0 || co.location[1] >= noc.mesh_y)
+	FATAL("core_overrides: location out of the mesh");
+      c = noc.getCoreID(co.location[0], co.location[1]);
+    }
+
+  if (c < 0 || c >= number_of_cores)
+    FATAL("core_overrides: core " + to_string(c) + " out of range");
+
+  return c;
+}
+
+int Architecture::getMaxCoreCapacity() const
+{
+  return *max_element(core_qubits.begin(), core_qubits.end());
+}
+
+void Architecture::buildCoreGateDelays(const map<string,double>& gate_delays,
+				       const double qscale_factor)
+{
+  core_gate_delays.assign(number_of_cores, gate_delays);
+
+  for (const auto& co : core_overrides)
+    {
+      map<string,double>& delays = core_gate_delays[getOverriddenCore(co)];
+      for (auto& kv : delays)
+	kv.second *= co.gate_delay_scale;
+      for (const auto& kv : co.gate_delays)
+	delays[kv.first] = kv.second * qscale_factor;
+    }
+
+  // the router inserts SWAPs in the cores with a coupling graph
+  if (coupling_graph != COUPLING_FULL)
+    for (int c = 0; c < number_of_cores; c++)
+      if (core_gate_delays[c].find("SWAP") == core_gate_delays[c].end())
+	{
+	  ostringstream oss;
+	  oss << "coupling_graph " << coupling_graph << " needs a delay for gate SWAP (gate_delays"
+	      << " of the parameters or of the core_overrides of core " << c << ")";
+	  FATAL(oss.str());
+	}
 }
 
 void Architecture::updateMeshX(const int nv)
@@ -99,6 +349,96 @@ void Architecture::updateLinkWidth(const int nv)
   noc.link_width = nv;
 }
 
+void Architecture::updateRoutingAlgorithm(const int nv)
+{
+  noc.routing_algorithm = nv;
+}
+
+void Architecture::updateFlowControl(const int nv)
+{
+  noc.flow_control = nv;
+}
+
+void Architecture::updateRouterPipeline(const int nv)
+{
+  noc.router_pipeline = nv;
+}
+
+void Architecture::updateBufferDepth(const int nv)
+{
+  noc.buffer_depth = nv;
+}
+
+void Architecture::updateVirtualChannels(const int nv)
+{
+  noc.virtual_channels = nv;
+}
+
+void Architecture::updateCoalescing(const int nv)
+{
+  noc.coalescing = nv;
+}
+
+void Architecture::updatePacketHeaderBits(const int nv)
+{
+  noc.packet_header_bits = nv;
+}
+
+void Architecture::updateMaxPacketBits(const int nv)
+{
+  noc.max_packet_bits = nv;
+}
+
+void Architecture::updateMulticast(const int nv)
+{
+  noc.multicast = nv;
+}
+
+void Architecture::updateQLinkChannels(const int nv)
+{
+  noc.qlink_channels = nv;
+}
+
+void Architecture::updateShuttleCapacity(const int nv)
+{
+  noc.shuttle_capacity = nv;
+}
+
+void Architecture::updateHybridMode(const int nv)
+{
+  noc.hybrid_mode = nv;
+}
+
+void Architecture::updateHybridHopThreshold(const int nv)
+{
+  noc.hybrid_hop_threshold = nv;
+}
+
+void Architecture::updateHybridVolumeThreshold(const int nv)
+{
+  noc.hybrid_volume_threshold = nv;
+}
+
+void Architecture::updateTopology(const int nv)
+{
+  noc.topology_type = nv;
+}
+
+void Architecture::updateTopologyFile(const string& nv)
+{
+  noc.topology_file = nv;
+}
+
+void Architecture::updateConcentration(const int nv)
+{
+  noc.concentration = nv;
+}
+
+void Architecture::updateGlobalLinkLatency(const int nv)
+{
+  noc.global_link_latency = nv;
+}
+
 void Architecture::updateQubitsPerCore(const int nv)
 {
   qubits_per_core = nv;
@@ -108,6 +448,22 @@ void Architecture::updateQubitsPerCore(const int nv)
 void Architecture::updateLTMPorts(const int nv)
 {
   ltm_ports = nv;
+  computeDerivedVariables();
+}
+
+void Architecture::updateCommQubits(const int nv)
+{
+  comm_qubits = nv;
+}
+
+void Architecture::updateCommOverflowToData(const int nv)
+{
+  comm_overflow_to_data = nv;
+}
+
+void Architecture::updateCouplingGraph(const int nv)
+{
+  coupling_graph = nv;
 }
 
 void Architecture::updateRadioChannels(const int nv)
@@ -135,9 +491,138 @@ void Architecture::updateDstSelectionMode(const int nv)
   dst_selection_mode = nv;
 }
 
+void Architecture::updateEvictionPolicy(const int nv)
+{
+  eviction_policy = nv;
+}
+
 void Architecture::updateMappingType(const int nv)
 {
   mapping_type = nv;
 }
 
+void Architecture::updateMappingFile(const string& nv)
+{
+  mapping_file = nv;
+}
+
+void Architecture::updateMappingOutputFile(const string& nv)
+{
+  mapping_output_file = nv;
+}
+
+void Architecture::updatePartitionDecay(const double nv)
+{
+  partition_decay = nv;
+}
+
+void Architecture::updatePartitionImbalance(const double nv)
+{
+  partition_imbalance = nv;
+}
+
+void Architecture::updatePartitionMeshAware(const int nv)
+{
+  partition_mesh_aware = nv;
+}
+
+void Architecture::updateLookaheadSlices(const int nv)
+{
+  lookahead_slices = nv;
+}
+
+void Architecture::updateLookaheadDiscount(const double nv)
+{
+  lookahead_discount = nv;
+}
+
+void Architecture::updateLookaheadLoadWeight(const double nv)
+{
+  lookahead_load_weight = nv;
+}
+
+void Architecture::updateLookaheadHopWeight(const double nv)
+{
+  lookahead_hop_weight = nv;
+}
+
+void Architecture::updateDstCostHopWeight(const double nv)
+{
+  dst_cost_hop_weight = nv;
+}
+
+void Architecture::updateDstCostPortWeight(const double nv)
+{
+  dst_cost_port_weight = nv;
+}
+
+void Architecture::updateDstCostLoadWeight(const double nv)
+{
+  dst_cost_load_weight = nv;
+}
+
+void Architecture::updateDstCostAncillaWeight(const double nv)
+{
+  dst_cost_ancilla_weight = nv;
+}
+
+void Architecture::updateRebalanceInterval(const int nv)
+{
+  rebalance_interval = nv;
+}
+
+void Architecture::updateRebalanceThreshold(const double nv)
+{
+  rebalance_threshold = nv;
+}
+
+void Architecture::updatePrefetchSlices(const int nv)
+{
+  prefetch_slices = nv;
+}
+
+void Architecture::updatePackingPolicy(const int nv)
+{
+  packing_policy = nv;
+}
+
+void Architecture::updateRemoteGateMode(const int nv)
+{
+  remote_gate_mode = nv;
+}
+
+void Architecture::updateMemoryInterfaces(const int nv)
+{
+  memory_interfaces.number = nv;
+}
+
+void Architecture::updateMIPlacement(const int nv)
+{
+  memory_interfaces.placement = nv;
+}
+
+// nv is a comma separated list of cores
+void Architecture::updateMICores(const string& nv)
+{
+  memory_interfaces.core_list.clear();
+
+  stringstream ss(nv);
+  string item;
+  while (getline(ss, item, ','))
+    memory_interfaces.core_list.push_back(stoi(item));
+}
+
+void Architecture::updateMIBandwidth(const double nv)
+{
+  memory_interfaces.bandwidth = nv;
+}
 
+void Architecture::updateMIAssignment(const int nv)
+{
+  memory_interfaces.assignment = nv;
+}
+
+void Architecture::updateICacheCapacity(const int nv)
+{
+  icache_capacity = nv;
+}
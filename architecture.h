@@ -9,34 +9,135 @@
 #ifndef __ARCHITECTURE_H__
 #define __ARCHITECTURE_H__
 
+#include <map>
 #include <string>
+#include <vector>
 #include "noc.h"
 #include "core.h"
+#include "memory_interface.h"
+#include "coupling.h"
 
 using namespace std;
 
 #define TP_TYPE_A2A  0
 #define TP_TYPE_MESH 1
+#define TP_TYPE_SWAP 2 // mesh links, end-to-end EPR pairs by entanglement swapping
+#define TP_TYPE_SHUTTLE 3 // the qubits (ions) are shuttled along the path (see NoC::getShuttlingTime)
 
 #define DST_SEL_LOAD_INDEPENDENT 0
 #define DST_SEL_LOAD_AWARE       1
+#define DST_SEL_LOOKAHEAD        2
+#define DST_SEL_COST             3
 
+#define EVICT_NONE     0
+#define EVICT_LRU      1
+#define EVICT_BELADY   2
+#define EVICT_NEIGHBOR 3
+
+#define PACK_GREEDY         0
+#define PACK_MATCHING       1
+#define PACK_CRITICAL_FIRST 2
+
+// How a remote gate is executed (TP_TYPE_A2A and TP_TYPE_SWAP only)
+#define REMOTE_TELEDATA 0 // its qubits are teleported to the core executing it
+#define REMOTE_TELEGATE 1 // two-qubit gates across the cores (cat-entanglement)
+#define REMOTE_ADAPTIVE 2 // per gate choice of the cheaper one, estimated with the next uses of the qubits
+
+// Override of the parameters of a core (core_overrides in the YAML
+// file), e.g. for the hub cores of a chip. The core is given by its
+// id or by its [x, y] location in the grid (mesh and torus). A zero
+// value keeps the global parameter. The gate delays of the core are
+// those of gate_delays if defined there, otherwise the ones of the
+// parameters times gate_delay_scale.
+struct CoreOverride
+{
+  int                 core; // -1 if given by location
+  vector<int>         location;
+  int                 qubits;
+  int                 ltm_ports;
+  double              gate_delay_scale;
+  map<string,double>  gate_delays; // sec
+
+  CoreOverride() : core(-1), qubits(0), ltm_ports(0), gate_delay_scale(1.0) {}
+};
 
 struct Architecture
 {
   int     qubits_per_core;
   int     ltm_ports;
+  int     comm_qubits; // communication qubits per core holding the relays (0 = data qubits)
+  bool    comm_overflow_to_data; // relays beyond comm_qubits in the data qubits instead of waiting
   int     number_of_cores; // derived value
   int     total_physical_qubits; // derived value
   int     teleportation_type;
   int     dst_selection_mode;
+  int     eviction_policy; // victim selection when a core is full (see eviction.h)
+  int     packing_policy; // order of the remote gates packed in the teleportation rounds
+  int     remote_gate_mode; // teledata or telegate (see Simulation::useTelegate)
   int     mapping_type;
+  string  mapping_file; // used with MAP_FILE
+  string  mapping_output_file; // final mapping is saved here if not empty
+
+  // Options of the partition based mapping (MAP_PARTITION)
+  double  partition_decay; // decay of the interaction weights with the slice index
+  double  partition_imbalance; // max allowed imbalance of core loads (0.1 = 10%)
+  bool    partition_mesh_aware; // weight cut edges by mesh distance (TP_TYPE_MESH only)
+
+  // Options of the lookahead destination selection (DST_SEL_LOOKAHEAD)
+  int     lookahead_slices; // number of future slices considered
+  double  lookahead_discount; // weight of a use k slices ahead is discount^k
+  double  lookahead_load_weight; // weight of the core occupancy (normalized to 0..1)
+  double  lookahead_hop_weight; // weight of the hops traveled by the teleported qubits
+
+  // Weights of the cost based destination selection (DST_SEL_COST)
+  double  dst_cost_hop_weight; // hops x link cycles of the teleported qubits
+  double  dst_cost_port_weight; // teleportations exceeding the free LTM ports
+  double  dst_cost_load_weight; // core occupancy (normalized to 0..1)
+  double  dst_cost_ancilla_weight; // ancillas needed along the path (TP_TYPE_MESH)
+
+  // Options of the background rebalancer (see rebalancer.h). It is
+  // disabled if both are 0
+  int     rebalance_interval; // slices between two rebalancing batches
+  double  rebalance_threshold; // core load imbalance that triggers a batch
+
+  // Number of slices scanned by the prefetch of the remote gate
+  // qubits (0 = disabled, not with TP_TYPE_MESH)
+  int     prefetch_slices;
+
+  // Memory interfaces dispatching the instructions (see
+  // memory_interface.h)
+  MemoryInterfaces memory_interfaces;
+
+  // Bits of the instruction buffer of each core (0 = disabled, see
+  // instruction_cache.h)
+  int     icache_capacity;
+
+  // Coupling graph of the qubits of a core (see coupling.h)
+  int     coupling_graph;
+
+  // Heterogeneous cores: overrides and resulting capacity, LTM ports
+  // and gate delays of each core (derived values)
+  vector<CoreOverride>        core_overrides;
+  vector<int>                 core_qubits;
+  vector<int>                 core_ltm_ports;
+  vector<map<string,double> > core_gate_delays; // see buildCoreGateDelays
 
   Cores&  cores;
   NoC&    noc;
   
   Architecture(Cores& cores_ref, NoC& noc_ref) : cores(cores_ref), noc(noc_ref) {}
 
+  bool isHeterogeneous() const { return !core_overrides.empty(); }
+  int  getCoreCapacity(const int core_id) const { return core_qubits[core_id]; }
+  int  getCoreLTMPorts(const int core_id) const { return core_ltm_ports[core_id]; }
+  int  getMaxCoreCapacity() const;
+
+  // Builds the gate delays of each core from the ones of the
+  // parameters (already scaled by qscale_factor), that also scales
+  // the delays of the overrides. Fails if a coupling graph is set and
+  // a core has no SWAP delay
+  void buildCoreGateDelays(const map<string,double>& gate_delays, const double qscale_factor);
+
   // Display architecture configuration including cores and NoC to the
   // stdout in YAML format
   void display() const;
@@ -51,14 +152,60 @@ struct Architecture
   void updateMeshX(const int nv);
   void updateMeshY(const int nv);
   void updateLinkWidth(const int nv);
+  void updateRoutingAlgorithm(const int nv);
+  void updateTopology(const int nv);
+  void updateFlowControl(const int nv);
+  void updateRouterPipeline(const int nv);
+  void updateBufferDepth(const int nv);
+  void updateVirtualChannels(const int nv);
+  void updateCoalescing(const int nv);
+  void updatePacketHeaderBits(const int nv);
+  void updateMaxPacketBits(const int nv);
+  void updateMulticast(const int nv);
+  void updateQLinkChannels(const int nv);
+  void updateShuttleCapacity(const int nv);
+  void updateHybridMode(const int nv);
+  void updateHybridHopThreshold(const int nv);
+  void updateHybridVolumeThreshold(const int nv);
+  void updateTopologyFile(const string& nv);
+  void updateConcentration(const int nv);
+  void updateGlobalLinkLatency(const int nv);
   void updateQubitsPerCore(const int nv);
   void updateLTMPorts(const int nv);
+  void updateCommQubits(const int nv);
+  void updateCommOverflowToData(const int nv);
+  void updateCouplingGraph(const int nv);
   void updateRadioChannels(const int nv);
   void updateWirelessEnabled(const int nv);
   void updateTeleportationType(const int nv);
   void updateWirelessMAC(const int nv);
   void updateDstSelectionMode(const int nv);
+  void updateEvictionPolicy(const int nv);
   void updateMappingType(const int nv);
+  void updateMappingFile(const string& nv);
+  void updateMappingOutputFile(const string& nv);
+  void updatePartitionDecay(const double nv);
+  void updatePartitionImbalance(const double nv);
+  void updatePartitionMeshAware(const int nv);
+  void updateLookaheadSlices(const int nv);
+  void updateLookaheadDiscount(const double nv);
+  void updateLookaheadLoadWeight(const double nv);
+  void updateLookaheadHopWeight(const double nv);
+  void updateDstCostHopWeight(const double nv);
+  void updateDstCostPortWeight(const double nv);
+  void updateDstCostLoadWeight(const double nv);
+  void updateDstCostAncillaWeight(const double nv);
+  void updateRebalanceInterval(const int nv);
+  void updateRebalanceThreshold(const double nv);
+  void updatePrefetchSlices(const int nv);
+  void updatePackingPolicy(const int nv);
+  void updateRemoteGateMode(const int nv);
+  void updateMemoryInterfaces(const int nv);
+  void updateMIPlacement(const int nv);
+  void updateMICores(const string& nv);
+  void updateMIBandwidth(const double nv);
+  void updateMIAssignment(const int nv);
+  void updateICacheCapacity(const int nv);
 
   // There are some attributes like number_of_cores and
   // total_physical_qubits that are not directly specified in the
@@ -66,6 +213,7 @@ struct Architecture
   // specified in the YAML file. The method computeDerivedVariables
   // takes care of computing such drivd attributes.
   void computeDerivedVariables();
+  int  getOverriddenCore(const CoreOverride& co) const;
 };
 
 #endif
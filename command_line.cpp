@@ -58,6 +58,42 @@ void overrideParameters(const map<string,string>& params_override,
 	arch.updateMeshY(stoi(value));
       else if (param == "link_width")	
 	arch.updateLinkWidth(stoi(value));
+      else if (param == "routing_algorithm")
+	arch.updateRoutingAlgorithm(stoi(value));
+      else if (param == "topology")
+	arch.updateTopology(stoi(value));
+      else if (param == "flow_control")
+	arch.updateFlowControl(stoi(value));
+      else if (param == "router_pipeline")
+	arch.updateRouterPipeline(stoi(value));
+      else if (param == "buffer_depth")
+	arch.updateBufferDepth(stoi(value));
+      else if (param == "virtual_channels")
+	arch.updateVirtualChannels(stoi(value));
+      else if (param == "coalescing")
+	arch.updateCoalescing(stoi(value));
+      else if (param == "packet_header_bits")
+	arch.updatePacketHeaderBits(stoi(value));
+      else if (param == "max_packet_bits")
+	arch.updateMaxPacketBits(stoi(value));
+      else if (param == "multicast")
+	arch.updateMulticast(stoi(value));
+      else if (param == "qlink_channels")
+	arch.updateQLinkChannels(stoi(value));
+      else if (param == "shuttle_capacity")
+	arch.updateShuttleCapacity(stoi(value));
+      else if (param == "hybrid_mode")
+	arch.updateHybridMode(stoi(value));
+      else if (param == "hybrid_hop_threshold")
+	arch.updateHybridHopThreshold(stoi(value));
+      else if (param == "hybrid_volume_threshold")
+	arch.updateHybridVolumeThreshold(stoi(value));
+      else if (param == "topology_file")
+	arch.updateTopologyFile(value);
+      else if (param == "concentration")
+	arch.updateConcentration(stoi(value));
+      else if (param == "global_link_latency")
+	arch.updateGlobalLinkLatency(stoi(value));
       else if (param == "qubits_per_core")
 	arch.updateQubitsPerCore(stoi(value));
       else if (param == "ltm_ports")
@@ -72,8 +108,64 @@ void overrideParameters(const map<string,string>& params_override,
 	arch.updateWirelessMAC(stoi(value));
       else if (param == "dst_selection_mode")
 	arch.updateDstSelectionMode(stoi(value));
+      else if (param == "eviction_policy")
+	arch.updateEvictionPolicy(stoi(value));
       else if (param == "mapping_type")
 	arch.updateMappingType(stoi(value));
+      else if (param == "mapping_file")
+	arch.updateMappingFile(value);
+      else if (param == "mapping_output_file")
+	arch.updateMappingOutputFile(value);
+      else if (param == "partition_decay")
+	arch.updatePartitionDecay(stod(value));
+      else if (param == "partition_imbalance")
+	arch.updatePartitionImbalance(stod(value));
+      else if (param == "partition_mesh_aware")
+	arch.updatePartitionMeshAware(stoi(value));
+      else if (param == "lookahead_slices")
+	arch.updateLookaheadSlices(stoi(value));
+      else if (param == "lookahead_discount")
+	arch.updateLookaheadDiscount(stod(value));
+      else if (param == "lookahead_load_weight")
+	arch.updateLookaheadLoadWeight(stod(value));
+      else if (param == "lookahead_hop_weight")
+	arch.updateLookaheadHopWeight(stod(value));
+      else if (param == "dst_cost_hop_weight")
+	arch.updateDstCostHopWeight(stod(value));
+      else if (param == "dst_cost_port_weight")
+	arch.updateDstCostPortWeight(stod(value));
+      else if (param == "dst_cost_load_weight")
+	arch.updateDstCostLoadWeight(stod(value));
+      else if (param == "dst_cost_ancilla_weight")
+	arch.updateDstCostAncillaWeight(stod(value));
+      else if (param == "rebalance_interval")
+	arch.updateRebalanceInterval(stoi(value));
+      else if (param == "rebalance_threshold")
+	arch.updateRebalanceThreshold(stod(value));
+      else if (param == "prefetch_slices")
+	arch.updatePrefetchSlices(stoi(value));
+      else if (param == "packing_policy")
+	arch.updatePackingPolicy(stoi(value));
+      else if (param == "remote_gate_mode")
+	arch.updateRemoteGateMode(stoi(value));
+      else if (param == "memory_interfaces")
+	arch.updateMemoryInterfaces(stoi(value));
+      else if (param == "mi_placement")
+	arch.updateMIPlacement(stoi(value));
+      else if (param == "mi_cores")
+	arch.updateMICores(value);
+      else if (param == "mi_bandwidth")
+	arch.updateMIBandwidth(stod(value));
+      else if (param == "mi_assignment")
+	arch.updateMIAssignment(stoi(value));
+      else if (param == "comm_qubits")
+	arch.updateCommQubits(stoi(value));
+      else if (param == "comm_overflow_to_data")
+	arch.updateCommOverflowToData(stoi(value));
+      else if (param == "coupling_graph")
+	arch.updateCouplingGraph(stoi(value));
+      else if (param == "icache_capacity")
+	arch.updateICacheCapacity(stoi(value));
       else if (param == "epr_delay")
 	params.updateEPRDelay(stod(value));
       else if (param == "dist_delay")
@@ -82,12 +174,22 @@ void overrideParameters(const map<string,string>& params_override,
 	params.updatePreDelay(stod(value));
       else if (param == "post_delay")
 	params.updatePostDelay(stod(value));
+      else if (param == "swap_delay")
+	params.updateSwapDelay(stod(value));
       else if (param == "noc_clock_time")
 	params.updateNoCClockTime(stod(value));
       else if (param == "wbit_rate")
 	params.updateWBitRate(stod(value));
       else if (param == "token_pass_time")
 	params.updateTokenPassTime(stod(value));
+      else if (param == "qlink_epr_rate")
+	params.updateQLinkEPRRate(stod(value));
+      else if (param == "qlink_hop_delay")
+	params.updateQLinkHopDelay(stod(value));
+      else if (param == "shuttle_segment_time")
+	params.updateShuttleSegmentTime(stod(value));
+      else if (param == "shuttle_junction_time")
+	params.updateShuttleJunctionTime(stod(value));
       else if (param == "memory_bandwidth")
 	params.updateMemoryBandwidth(stod(value));
       else if (param == "bits_instruction")
@@ -108,4 +210,8 @@ void overrideParameters(const map<string,string>& params_override,
 	FATAL(oss.str());
       }
     }
+
+  // The topology depends on several parameters, thus it is rebuilt
+  // once all of them have been overridden
+  arch.computeDerivedVariables();
 }
@@ -10,6 +10,25 @@
 #include "communication.h"
 
 
+Communication::Communication(int src, const vector<int>& dsts, const vector<int>& dst_vols,
+			     int shared_vol)
+  : src_core(src), dst_core(dsts.front()), volume(shared_vol),
+    dst_cores(dsts), dst_volumes(dst_vols)
+{
+  for (int v : dst_volumes)
+    volume += v;
+}
+
+int Communication::getSharedVolume() const
+{
+  int shared = volume;
+
+  for (int v : dst_volumes)
+    shared -= v;
+
+  return shared;
+}
+
 bool Communication::operator<(const Communication& other) const
 {
   if (src_core < other.src_core) {
@@ -23,7 +42,17 @@ bool Communication::operator<(const Communication& other) const
 
 void Communication::display() const
 {
-  cout << src_core << "->" << dst_core << "(" << volume << ")";
+  cout << src_core << "->";
+  if (isMulticast())
+    {
+      cout << "{";
+      for (unsigned int i = 0; i < dst_cores.size(); i++)
+	cout << (i > 0 ? "," : "") << dst_cores[i];
+      cout << "}";
+    }
+  else
+    cout << dst_core;
+  cout << "(" << volume << ")";
 }
 
 void displayParallelCommunications(const ParallelCommunications& pc)
@@ -11,16 +11,30 @@
 #define __COMMUNICATION_H__
 
 #include <list>
+#include <vector>
 
 using namespace std;
 
+// A multicast communication delivers a message to all the cores in
+// dst_cores (dst_core is one of them). Part of the message is shared
+// by all the destinations, while dst_volumes[i] bits are addressed
+// to dst_cores[i] only and can be dropped by the branches not
+// leading to it. dst_cores is empty for a unicast communication.
 struct Communication
 {
   int src_core;
   int dst_core;
-  int volume;
+  int volume; // whole message
+  vector<int> dst_cores;
+  vector<int> dst_volumes;
   
   Communication(int src, int dst, int vol) : src_core(src), dst_core(dst), volume(vol) {}
+  Communication(int src, const vector<int>& dsts, const vector<int>& dst_vols,
+		int shared_vol);
+
+  bool isMulticast() const { return !dst_cores.empty(); }
+
+  int getSharedVolume() const;
 
   bool operator<(const Communication& other) const;
   
@@ -13,7 +13,7 @@
 #include "core.h"
 
 
-void Cores::initCores(const int number_of_cores, const int qubits_per_core)
+void Cores::initCores(const int number_of_cores, const vector<int>& capacity)
 {
   ancilla_counter = 0;
   
@@ -32,7 +32,7 @@ void Cores::initCores(const int number_of_cores, const int qubits_per_core)
       
       cores[core_no].insert(qb);
       
-      if ((int)cores[core_no].size() > qubits_per_core)
+      if ((int)cores[core_no].size() > capacity[core_no])
 	{
 	  ostringstream oss;
 	  oss << "Number of qubits mapped on core " << core_no
@@ -65,12 +65,10 @@ void Cores::display()
       cout << IND << IND << IND << "'core " << core_id << "': ";
       cout << "[";
 
-      set<int> qbs = cores[core_id];
-      auto it = qbs.begin();
-      auto last = prev(qbs.end());
-      for (; it != qbs.end(); ++it) {      
+      const set<int>& qbs = cores[core_id];
+      for (auto it = qbs.begin(); it != qbs.end(); ++it) {
 	cout << *it;
-	if (it != last)
+	if (next(it) != qbs.end())
 	  cout << ", ";
       }
       cout << "]" << endl;
@@ -87,9 +85,7 @@ bool Cores::allocateAncilla(const int core_id,
 			    const int qubits_per_core,
 			    int& ancilla)
 {
-  Core core = cores[core_id];
-
-  if ((int)core.size() >= qubits_per_core)
+  if ((int)cores[core_id].size() >= qubits_per_core)
     return false;
 
   ancilla = generateAncillaId();
@@ -99,3 +95,38 @@ bool Cores::allocateAncilla(const int core_id,
   return true;
 }
 
+void Cores::initCommPool(const int number_of_cores, const int capacity)
+{
+  comm_capacity = capacity;
+  comm_used.assign(number_of_cores, 0);
+  comm_ancillas.clear();
+}
+
+bool Cores::allocateCommQubit(const int core_id, int& ancilla, const bool wait)
+{
+  if (comm_capacity == 0 || (comm_used[core_id] >= comm_capacity && !wait))
+    return false;
+
+  ancilla = generateAncillaId();
+  comm_ancillas.insert(ancilla);
+  comm_used[core_id]++;
+  mapping.qubit2core[ancilla] = core_id;
+
+  return true;
+}
+
+void Cores::releaseCommQubit(const int core_id, const int ancilla)
+{
+  if (comm_ancillas.erase(ancilla) > 0)
+    comm_used[core_id]--;
+}
+
+int Cores::getCommWaiting(const int core_id) const
+{
+  return max(0, comm_used[core_id] - comm_capacity);
+}
+
+bool Cores::isCommQubit(const int qb) const
+{
+  return (comm_ancillas.find(qb) != comm_ancillas.end());
+}
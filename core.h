@@ -22,10 +22,19 @@ struct Cores
   list<vector<Core> > history;
   int                 ancilla_counter;
   Mapping&            mapping;
+
+  // Pool of communication qubits of each core, next to its LTM
+  // ports. They hold the relay ancillas and are not part of the
+  // qubits of the core (see Architecture::comm_qubits). The relays
+  // beyond comm_capacity wait for a free one
+  int                 comm_capacity; // per core, 0 = no pool
+  vector<int>         comm_used; // may exceed comm_capacity
+  set<int>            comm_ancillas;
   
-  Cores(Mapping& mapping_ref) : mapping(mapping_ref) {}
+  Cores(Mapping& mapping_ref) : mapping(mapping_ref), comm_capacity(0) {}
 
-  void initCores(const int number_of_cores, const int qubits_per_core);
+  // capacity[c] is the number of qubits of core c
+  void initCores(const int number_of_cores, const vector<int>& capacity);
 
   int getNumCores() const;
   
@@ -33,6 +42,15 @@ struct Cores
 		       const int qubits_per_core,
 		       int& ancilla);
   int generateAncillaId();
+
+  void initCommPool(const int number_of_cores, const int capacity);
+  // Returns false if the pool of core_id is full, unless wait is
+  // true: the relay is then allocated beyond comm_capacity
+  bool allocateCommQubit(const int core_id, int& ancilla, const bool wait = false);
+  // Relays of core_id waiting for a free communication qubit
+  int getCommWaiting(const int core_id) const;
+  void releaseCommQubit(const int core_id, const int ancilla);
+  bool isCommQubit(const int qb) const;
   
   void saveHistory();
   
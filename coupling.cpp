@@ -0,0 +1,321 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: coupling.cpp
+// Description: Implementation of the intra-core coupling graph and of the
+//              SWAP router of the local gates
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <string>
+#include "utils.h"
+#include "coupling.h"
+
+static const int FREE_POSITION = numeric_limits<int>::min();
+
+// ----------------------------------------------------------------------
+void IntraCoreRouter::reset(const int coupling_type, const vector<int>& core_qubits,
+			    const vector<int>& core_ltm_ports, const Cores& cores)
+{
+  type = coupling_type;
+  graphs.clear();
+  graph_of_core.clear();
+  placement.clear();
+  location.clear();
+
+  if (!isEnabled())
+    return;
+
+  int ncores = cores.getNumCores();
+  map<pair<int,int>,int> built; // (qubits, LTM ports) -> index in graphs
+  placement.resize(ncores);
+  next_port.assign(ncores, 0);
+
+  for (int c = 0; c < ncores; c++)
+    {
+      int n = core_qubits[c], ltm_ports = core_ltm_ports[c];
+      auto it = built.find(make_pair(n, ltm_ports));
+      if (it == built.end())
+	{
+	  CouplingGraph graph;
+	  buildGraph(graph, n);
+	  computeDistances(graph);
+
+	  for (int i = 0; i < min(ltm_ports, n); i++)
+	    graph.ports.push_back(i * n / ltm_ports);
+	  if (graph.ports.empty())
+	    graph.ports.push_back(0);
+
+	  it = built.insert(make_pair(make_pair(n, ltm_ports), (int)graphs.size())).first;
+	  graphs.push_back(graph);
+	}
+      graph_of_core.push_back(it->second);
+      placement[c].assign(n, FREE_POSITION);
+
+      if ((int)cores.cores[c].size() > n)
+	FATAL("core " + to_string(c) + " holds more qubits than its coupling graph");
+
+      int p = 0;
+      for (int qb : cores.cores[c])
+	{
+	  placement[c][p] = qb;
+	  location[qb] = make_pair(c, p);
+	  p++;
+	}
+    }
+}
+
+// ----------------------------------------------------------------------
+void IntraCoreRouter::buildGraph(CouplingGraph& coupling, const int n)
+{
+  vector<vector<int> >& adjacency = coupling.adjacency;
+  adjacency.assign(n, vector<int>());
+
+  auto link = [&adjacency](const int a, const int b) {
+    adjacency[a].push_back(b);
+    adjacency[b].push_back(a);
+  };
+
+  if (type == COUPLING_LINEAR)
+    {
+      for (int p = 1; p < n; p++)
+	link(p-1, p);
+    }
+  else if (type == COUPLING_GRID)
+    {
+      int cols = ceil(sqrt(n));
+      for (int p = 0; p < n; p++)
+	{
+	  if (p % cols > 0)
+	    link(p-1, p);
+	  if (p >= cols)
+	    link(p-cols, p);
+	}
+    }
+  else if (type == COUPLING_HEAVY_HEX)
+    {
+      // rows of width qubits and the bridges below them, until there
+      // are at least n nodes
+      int width = max(3, (int)ceil(sqrt(n)));
+      vector<vector<int> > graph;
+      vector<int> prev_row;
+      int row = 0;
+      while ((int)graph.size() < n)
+	{
+	  vector<int> cur_row;
+	  for (int c = 0; c < width; c++)
+	    {
+	      cur_row.push_back(graph.size());
+	      graph.push_back(vector<int>());
+	      if (c > 0)
+		{
+		  graph[cur_row[c-1]].push_back(cur_row[c]);
+		  graph[cur_row[c]].push_back(cur_row[c-1]);
+		}
+	    }
+
+	  if (row > 0)
+	    for (int c = ((row-1) % 2 == 0) ? 0 : 2; c < width; c += 4)
+	      {
+		int bridge = graph.size();
+		graph.push_back({prev_row[c], cur_row[c]});
+		graph[prev_row[c]].push_back(bridge);
+		graph[cur_row[c]].push_back(bridge);
+	      }
+
+	  prev_row = cur_row;
+	  row++;
+	}
+
+      // the first n nodes reached from a corner are kept, so that the
+      // positions are connected
+      vector<int> id(graph.size(), -1);
+      queue<int> frontier;
+      int next_id = 0;
+      id[0] = next_id++;
+      frontier.push(0);
+      while (!frontier.empty())
+	{
+	  int node = frontier.front();
+	  frontier.pop();
+	  for (int nb : graph[node])
+	    if (id[nb] == -1)
+	      {
+		id[nb] = next_id++;
+		frontier.push(nb);
+	      }
+	}
+
+      for (int node = 0; node < (int)graph.size(); node++)
+	for (int nb : graph[node])
+	  if (id[node] < n && id[nb] < n && id[node] < id[nb])
+	    link(id[node], id[nb]);
+    }
+  else
+    FATAL("undefined coupling_graph " + to_string(type));
+}
+
+// ----------------------------------------------------------------------
+void IntraCoreRouter::computeDistances(CouplingGraph& graph)
+{
+  const vector<vector<int> >& adjacency = graph.adjacency;
+  vector<vector<int> >& distance = graph.distance;
+  int n = adjacency.size();
+  distance.assign(n, vector<int>(n, -1));
+
+  for (int src = 0; src < n; src++)
+    {
+      queue<int> frontier;
+      distance[src][src] = 0;
+      frontier.push(src);
+      while (!frontier.empty())
+	{
+	  int p = frontier.front();
+	  frontier.pop();
+	  for (int nb : adjacency[p])
+	    if (distance[src][nb] == -1)
+	      {
+		distance[src][nb] = distance[src][p] + 1;
+		frontier.push(nb);
+	      }
+	}
+    }
+}
+
+// ----------------------------------------------------------------------
+int IntraCoreRouter::landingPosition(const int core_id)
+{
+  const CouplingGraph& graph = graphs[graph_of_core[core_id]];
+  const vector<int>& ports = graph.ports;
+  const vector<int>& slots = placement[core_id];
+  int port = ports[next_port[core_id]];
+  next_port[core_id] = (next_port[core_id] + 1) % ports.size();
+
+  int selected = -1;
+  for (int p = 0; p < (int)slots.size(); p++)
+    if (slots[p] == FREE_POSITION &&
+	(selected == -1 || graph.distance[port][p] < graph.distance[port][selected]))
+      selected = p;
+
+  if (selected == -1)
+    FATAL("core " + to_string(core_id) + " holds more qubits than its coupling graph");
+
+  return selected;
+}
+
+// ----------------------------------------------------------------------
+void IntraCoreRouter::sync(const int core_id, const Core& core)
+{
+  vector<int>& slots = placement[core_id];
+
+  for (int& qb : slots)
+    if (qb != FREE_POSITION && core.find(qb) == core.end())
+      {
+	auto it = location.find(qb);
+	if (it != location.end() && it->second.first == core_id)
+	  location.erase(it);
+	qb = FREE_POSITION;
+      }
+
+  for (int qb : core)
+    {
+      auto it = location.find(qb);
+      if (it != location.end())
+	{
+	  if (it->second.first == core_id)
+	    continue;
+
+	  // the qubit left a core not synchronized yet
+	  int& old_slot = placement[it->second.first][it->second.second];
+	  if (old_slot == qb)
+	    old_slot = FREE_POSITION;
+	}
+
+      int p = landingPosition(core_id);
+      slots[p] = qb;
+      location[qb] = make_pair(core_id, p);
+    }
+}
+
+// ----------------------------------------------------------------------
+void IntraCoreRouter::swapPositions(const int core_id, const int p1, const int p2)
+{
+  vector<int>& slots = placement[core_id];
+  swap(slots[p1], slots[p2]);
+
+  if (slots[p1] != FREE_POSITION)
+    location[slots[p1]] = make_pair(core_id, p1);
+  if (slots[p2] != FREE_POSITION)
+    location[slots[p2]] = make_pair(core_id, p2);
+}
+
+// ----------------------------------------------------------------------
+int IntraCoreRouter::route(const int core_id, const Gate& gate)
+{
+  // the communication qubits (see Cores::comm_capacity) are next to
+  // the ports, not in the coupling graph
+  list<int> placed;
+  for (int qb : gate.second)
+    {
+      auto it = location.find(qb);
+      if (it != location.end() && it->second.first == core_id)
+	placed.push_back(qb);
+    }
+
+  if (placed.size() < 2)
+    return 0;
+
+  const vector<vector<int> >& adjacency = graphs[graph_of_core[core_id]].adjacency;
+  const vector<vector<int> >& distance = graphs[graph_of_core[core_id]].distance;
+
+  // the qubits move toward the one nearest to the others
+  int anchor = placed.front(), min_sum = -1;
+  for (int qa : placed)
+    {
+      int sum = 0;
+      for (int qb : placed)
+	sum += distance[location[qa].second][location[qb].second];
+      if (min_sum == -1 || sum < min_sum)
+	{
+	  anchor = qa;
+	  min_sum = sum;
+	}
+    }
+
+  int swaps = 0;
+  int pa = location[anchor].second;
+  for (int qb : placed)
+    {
+      if (qb == anchor)
+	continue;
+
+      int p = location[qb].second;
+      while (distance[p][pa] > 1)
+	{
+	  // next position along a shortest path, preferably not holding
+	  // another qubit of the gate
+	  int next_p = -1;
+	  for (int nb : adjacency[p])
+	    if (distance[nb][pa] == distance[p][pa] - 1)
+	      {
+		int occupant = placement[core_id][nb];
+		bool of_gate = (occupant != FREE_POSITION &&
+				find(placed.begin(), placed.end(), occupant) != placed.end());
+		if (next_p == -1 || !of_gate)
+		  next_p = nb;
+		if (!of_gate)
+		  break;
+	      }
+
+	  swapPositions(core_id, p, next_p);
+	  p = next_p;
+	  swaps++;
+	}
+    }
+
+  return swaps;
+}
@@ -0,0 +1,85 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: coupling.h
+// Description: Declaration of the intra-core coupling graph and of the
+//              SWAP router of the local gates
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __COUPLING_H__
+#define __COUPLING_H__
+
+#include <map>
+#include <vector>
+#include "core.h"
+#include "gate.h"
+
+using namespace std;
+
+#define COUPLING_FULL      0 // all-to-all, no SWAPs
+#define COUPLING_LINEAR    1
+#define COUPLING_GRID      2
+#define COUPLING_HEAVY_HEX 3
+
+// The positions of a core, as many as its qubits, are the nodes of a
+// coupling graph, the same for all the cores with the same number of
+// qubits and LTM ports:
+// - COUPLING_LINEAR: a chain;
+// - COUPLING_GRID: a grid of ceil(sqrt(n)) columns filled row by row;
+// - COUPLING_HEAVY_HEX: rows of ceil(sqrt(n)) qubits linked by bridge
+//   qubits every 4 columns, alternately at offset 0 and 2 (the
+//   positions are the first n nodes in BFS order from a corner).
+// The LTM ports are the positions ports[i], evenly spaced by index.
+// The qubits initially mapped to a core take the positions in
+// order. A qubit teleported into a core lands at the free position
+// nearest to a port (the ports are used round robin).
+//
+// Before a gate is executed, its qubits are brought next to each
+// other by a chain of SWAPs along a shortest path: each qubit moves
+// toward the qubit of the gate nearest to the others until they are
+// adjacent.
+struct CouplingGraph
+{
+  vector<vector<int> > adjacency;
+  vector<vector<int> > distance; // hops between two positions
+  vector<int>          ports;
+};
+
+struct IntraCoreRouter
+{
+  int                   type;
+  vector<CouplingGraph> graphs;
+  vector<int>           graph_of_core; // index in graphs
+
+  // placement[c][p] is the qubit at position p of core c and
+  // location maps a qubit to its (core, position)
+  vector<vector<int> >  placement;
+  map<int,pair<int,int> > location;
+  vector<int>           next_port; // next port of each core a qubit lands to
+
+  IntraCoreRouter() : type(COUPLING_FULL) {}
+
+  bool isEnabled() const { return type != COUPLING_FULL; }
+
+  // Builds the coupling graphs of cores, whose core c has
+  // core_qubits[c] qubits and core_ltm_ports[c] LTM ports, and places
+  // their qubits
+  void reset(const int coupling_type, const vector<int>& core_qubits,
+	     const vector<int>& core_ltm_ports, const Cores& cores);
+
+  // Aligns the placement of core_id with its qubits: the qubits left
+  // free their positions and the new ones land near the ports
+  void sync(const int core_id, const Core& core);
+
+  // Moves the qubits of gate, all in core_id, next to each other.
+  // Returns the number of SWAPs
+  int route(const int core_id, const Gate& gate);
+
+  void buildGraph(CouplingGraph& graph, const int n);
+  void computeDistances(CouplingGraph& graph);
+  int  landingPosition(const int core_id);
+  void swapPositions(const int core_id, const int p1, const int p2);
+};
+
+#endif
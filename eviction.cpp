@@ -0,0 +1,153 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: eviction.cpp
+// Description: Implementation of the eviction policies used when a core is full
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <limits>
+#include "eviction.h"
+
+// ----------------------------------------------------------------------
+void EvictionManager::reset()
+{
+  last_use.clear();
+  step = 0;
+}
+
+// ----------------------------------------------------------------------
+void EvictionManager::touch(const ParallelGates& pgates)
+{
+  for (const auto& gate : pgates)
+    for (int qb : gate.second)
+      last_use[qb] = step;
+
+  step++;
+}
+
+// ----------------------------------------------------------------------
+bool EvictionManager::isEvictable(const int qb, const set<int>& protected_qubits) const
+{
+  // ancillas (negative ids) hold the state of a qubit in transit
+  return (qb >= 0 && protected_qubits.find(qb) == protected_qubits.end());
+}
+
+// ----------------------------------------------------------------------
+int EvictionManager::selectTargetCore(const Architecture& architecture, const Cores& cores,
+				      const int core_id)
+{
+  int target = -1;
+  int min_hops = numeric_limits<int>::max();
+  int min_size = numeric_limits<int>::max();
+
+  for (int c = 0; c < cores.getNumCores(); c++)
+    {
+      int size = cores.cores[c].size();
+      if (c == core_id || size >= architecture.getCoreCapacity(c))
+	continue;
+
+      int hops = architecture.noc.getHopDistance(core_id, c);
+      if (hops < min_hops || (hops == min_hops && size < min_size))
+	{
+	  min_hops = hops;
+	  min_size = size;
+	  target = c;
+	}
+    }
+
+  return target;
+}
+
+// ----------------------------------------------------------------------
+bool EvictionManager::selectEviction(const Architecture& architecture, const Mapping& mapping,
+				     const Cores& cores, LookaheadIndex& lookahead,
+				     const int current_slice, const int core_id,
+				     const set<int>& protected_qubits, Eviction& eviction)
+{
+  eviction.qubit = -1;
+  eviction.src_core = core_id;
+  eviction.dst_core = -1;
+
+  if (architecture.eviction_policy == EVICT_NEIGHBOR)
+    {
+      const list<int> no_exclude;
+      double min_cost = 0.0;
+
+      for (int qb : cores.cores[core_id])
+	{
+	  if (!isEvictable(qb, protected_qubits))
+	    continue;
+
+	  double aff_src = lookahead.affinity(qb, core_id, current_slice,
+					      architecture.lookahead_slices,
+					      architecture.lookahead_discount,
+					      mapping, no_exclude);
+
+	  for (int c = 0; c < cores.getNumCores(); c++)
+	    {
+	      int size = cores.cores[c].size();
+	      if (c == core_id || size >= architecture.getCoreCapacity(c))
+		continue;
+
+	      double aff_dst = lookahead.affinity(qb, c, current_slice,
+						  architecture.lookahead_slices,
+						  architecture.lookahead_discount,
+						  mapping, no_exclude);
+	      double cost = aff_src - aff_dst
+		+ architecture.lookahead_hop_weight * architecture.noc.getHopDistance(core_id, c)
+		+ architecture.lookahead_load_weight * size / architecture.getCoreCapacity(c);
+
+	      if (eviction.qubit == -1 || cost < min_cost)
+		{
+		  min_cost = cost;
+		  eviction.qubit = qb;
+		  eviction.dst_core = c;
+		}
+	    }
+	}
+
+      return (eviction.qubit != -1);
+    }
+
+  eviction.dst_core = selectTargetCore(architecture, cores, core_id);
+  if (eviction.dst_core == -1)
+    return false;
+
+  if (architecture.eviction_policy == EVICT_LRU)
+    {
+      long oldest = numeric_limits<long>::max();
+      for (int qb : cores.cores[core_id])
+	{
+	  if (!isEvictable(qb, protected_qubits))
+	    continue;
+
+	  // never used qubits are the least recently used ones
+	  auto it = last_use.find(qb);
+	  long used = (it == last_use.end()) ? -1 : it->second;
+	  if (used < oldest)
+	    {
+	      oldest = used;
+	      eviction.qubit = qb;
+	    }
+	}
+    }
+  else if (architecture.eviction_policy == EVICT_BELADY)
+    {
+      int furthest = -1;
+      for (int qb : cores.cores[core_id])
+	{
+	  if (!isEvictable(qb, protected_qubits))
+	    continue;
+
+	  int next_use = lookahead.nextUse(qb, current_slice);
+	  if (next_use > furthest)
+	    {
+	      furthest = next_use;
+	      eviction.qubit = qb;
+	    }
+	}
+    }
+
+  return (eviction.qubit != -1);
+}
@@ -0,0 +1,70 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: eviction.h
+// Description: Declaration of the eviction policies used when a core is full
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __EVICTION_H__
+#define __EVICTION_H__
+
+#include <map>
+#include <set>
+#include "architecture.h"
+#include "core.h"
+#include "gate.h"
+#include "mapping.h"
+#include "lookahead.h"
+
+using namespace std;
+
+// Migration of a qubit from a full core to a core with free capacity
+struct Eviction
+{
+  int qubit;
+  int src_core;
+  int dst_core;
+};
+
+// When a qubit (or an ancilla) has to be placed on a full core, a
+// victim qubit of that core is migrated to a core with free capacity
+// by means of an additional teleportation. The victim is selected
+// according to architecture.eviction_policy:
+// - EVICT_LRU: least recently used qubit;
+// - EVICT_BELADY: qubit whose next use is the furthest in the future;
+// - EVICT_NEIGHBOR: the (victim, target core) pair that minimizes the
+//   loss of lookahead affinity plus the weighted hop distance and
+//   load of the target core (lookahead_* weights).
+// With EVICT_LRU and EVICT_BELADY the victim is migrated to the
+// nearest core with free capacity (ties broken by load). Ancillas and
+// protected qubits (used by the gates being scheduled) are never
+// evicted.
+struct EvictionManager
+{
+  map<int,long> last_use; // qubit -> step of its last use (EVICT_LRU)
+  long          step;
+
+  EvictionManager() : step(0) {}
+
+  void reset();
+
+  // Records the use of the qubits of pgates and advances the step
+  void touch(const ParallelGates& pgates);
+
+  // Selects the victim of core_id and the core it is migrated
+  // to. Returns false if no qubit can be evicted or no core has free
+  // capacity.
+  bool selectEviction(const Architecture& architecture, const Mapping& mapping,
+		      const Cores& cores, LookaheadIndex& lookahead,
+		      const int current_slice, const int core_id,
+		      const set<int>& protected_qubits, Eviction& eviction);
+
+  // Nearest core with free capacity other than core_id, -1 if none
+  int selectTargetCore(const Architecture& architecture, const Cores& cores,
+		       const int core_id);
+
+  bool isEvictable(const int qb, const set<int>& protected_qubits) const;
+};
+
+#endif
@@ -0,0 +1,44 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: instruction_cache.cpp
+// Description: Implementation of the per-core instruction buffers
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include "instruction_cache.h"
+
+// ----------------------------------------------------------------------
+void InstructionCache::reset(const int ncores, const int capacity_bits)
+{
+  capacity = capacity_bits;
+  entries.assign(ncores, list<pair<size_t,int> >());
+  used_bits.assign(ncores, 0);
+}
+
+// ----------------------------------------------------------------------
+bool InstructionCache::access(const int core_id, const size_t fingerprint, const int bits)
+{
+  list<pair<size_t,int> >& buffer = entries[core_id];
+
+  for (auto it = buffer.begin(); it != buffer.end(); ++it)
+    if (it->first == fingerprint)
+      {
+	buffer.splice(buffer.begin(), buffer, it);
+	return true;
+      }
+
+  if (bits > capacity)
+    return false;
+
+  while (used_bits[core_id] + bits > capacity)
+    {
+      used_bits[core_id] -= buffer.back().second;
+      buffer.pop_back();
+    }
+
+  buffer.push_front(make_pair(fingerprint, bits));
+  used_bits[core_id] += bits;
+
+  return false;
+}
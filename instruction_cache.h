@@ -0,0 +1,44 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: instruction_cache.h
+// Description: Declaration of the per-core instruction buffers
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __INSTRUCTION_CACHE_H__
+#define __INSTRUCTION_CACHE_H__
+
+#include <list>
+#include <vector>
+
+using namespace std;
+
+// Each core has an instruction buffer of capacity bits holding the
+// most recently dispatched bundles (the instructions of a slice
+// addressed to the core). A bundle is identified by its fingerprint,
+// a hash of its operations and qubits. A bundle found in the buffer
+// is replayed locally, thus it is neither fetched nor dispatched.
+// Bundles are replaced in LRU order and a bundle larger than the
+// buffer is never stored.
+struct InstructionCache
+{
+  int capacity; // bits per core, 0 = disabled
+
+  // entries[c] are the bundles in the buffer of core c from the most
+  // to the least recently used: (fingerprint, bits)
+  vector<list<pair<size_t,int> > > entries;
+  vector<int> used_bits;
+
+  InstructionCache() : capacity(0) {}
+
+  void reset(const int ncores, const int capacity_bits);
+
+  bool isEnabled() const { return capacity > 0; }
+
+  // Looks up the bundle of core_id. On a miss the bundle is stored.
+  // Returns true on a hit.
+  bool access(const int core_id, const size_t fingerprint, const int bits);
+};
+
+#endif
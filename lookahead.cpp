@@ -0,0 +1,140 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: lookahead.cpp
+// Description: Implementation of the next-use index of the circuit qubits
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include "lookahead.h"
+
+// ----------------------------------------------------------------------
+void LookaheadIndex::build(const Circuit& circuit)
+{
+  uses.assign(circuit.number_of_qubits, QubitUses());
+
+  int slice = 0;
+  for (const auto& pg : circuit.circuit)
+    {
+      for (const auto& gate : pg)
+	for (int qb : gate.second)
+	  {
+	    if (!isIndexed(qb))
+	      continue;
+
+	    QubitUses& qu = uses[qb];
+	    qu.slice.push_back(slice);
+	    for (int p : gate.second)
+	      if (p != qb)
+		qu.partners.push_back(p);
+	    qu.pbegin.push_back(qu.partners.size());
+	  }
+      slice++;
+    }
+
+  // Depths are computed backward: the depth of a gate is one plus the
+  // largest depth of the next uses of its qubits
+  vector<int> next(circuit.number_of_qubits);
+  for (int qb = 0; qb < circuit.number_of_qubits; qb++)
+    {
+      next[qb] = uses[qb].slice.size();
+      uses[qb].depth.assign(next[qb], 0);
+    }
+
+  for (auto it = circuit.circuit.rbegin(); it != circuit.circuit.rend(); ++it)
+    for (const auto& gate : *it)
+      {
+	int d = 0;
+	for (int qb : gate.second)
+	  if (isIndexed(qb))
+	    {
+	      const QubitUses& qu = uses[qb];
+	      if (next[qb] < (int)qu.slice.size())
+		d = max(d, qu.depth[next[qb]]);
+	    }
+
+	for (int qb : gate.second)
+	  if (isIndexed(qb))
+	    {
+	      next[qb]--;
+	      uses[qb].depth[next[qb]] = d + 1;
+	    }
+      }
+}
+
+// ----------------------------------------------------------------------
+bool LookaheadIndex::isIndexed(const int qb) const
+{
+  // ancillas (negative ids) are not part of the circuit
+  return (qb >= 0 && qb < (int)uses.size());
+}
+
+// ----------------------------------------------------------------------
+void LookaheadIndex::advance(const int qb, const int slice)
+{
+  QubitUses& qu = uses[qb];
+
+  while (qu.cursor < qu.slice.size() && qu.slice[qu.cursor] < slice)
+    qu.cursor++;
+}
+
+// ----------------------------------------------------------------------
+int LookaheadIndex::nextUse(const int qb, const int current_slice)
+{
+  if (!isIndexed(qb))
+    return numeric_limits<int>::max();
+
+  advance(qb, current_slice + 1);
+
+  const QubitUses& qu = uses[qb];
+  if (qu.cursor == qu.slice.size())
+    return numeric_limits<int>::max();
+
+  return qu.slice[qu.cursor];
+}
+
+// ----------------------------------------------------------------------
+int LookaheadIndex::remainingDepth(const int qb, const int current_slice)
+{
+  if (!isIndexed(qb))
+    return 0;
+
+  advance(qb, current_slice + 1);
+
+  const QubitUses& qu = uses[qb];
+  if (qu.cursor == qu.slice.size())
+    return 0;
+
+  return qu.depth[qu.cursor];
+}
+
+// ----------------------------------------------------------------------
+double LookaheadIndex::affinity(const int qb, const int core_id, const int current_slice,
+				const int window, const double discount,
+				const Mapping& mapping, const list<int>& exclude)
+{
+  if (!isIndexed(qb))
+    return 0.0;
+
+  advance(qb, current_slice + 1);
+
+  const QubitUses& qu = uses[qb];
+  double aff = 0.0;
+  for (size_t i = qu.cursor;
+       i < qu.slice.size() && qu.slice[i] <= current_slice + window; i++)
+    {
+      double w = pow(discount, qu.slice[i] - current_slice - 1);
+      for (int j = qu.pbegin[i]; j < qu.pbegin[i+1]; j++)
+	{
+	  int p = qu.partners[j];
+	  if (mapping.isMapped(p) && mapping.qubit2core.at(p) == core_id &&
+	      find(exclude.begin(), exclude.end(), p) == exclude.end())
+	    aff += w;
+	}
+    }
+
+  return aff;
+}
@@ -0,0 +1,68 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: lookahead.h
+// Description: Declaration of the next-use index of the circuit qubits
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __LOOKAHEAD_H__
+#define __LOOKAHEAD_H__
+
+#include <vector>
+#include "circuit.h"
+#include "mapping.h"
+
+using namespace std;
+
+// Uses of a qubit in the circuit ordered by slice. The partners of
+// the i-th use (the other qubits of the gate) are
+// partners[pbegin[i]..pbegin[i+1]-1]. depth[i] is the length of the
+// longest chain of dependent gates starting with the gate of the i-th
+// use
+struct QubitUses
+{
+  vector<int> slice;
+  vector<int> pbegin;
+  vector<int> partners;
+  vector<int> depth;
+  size_t      cursor; // first use not in the past
+
+  QubitUses() : cursor(0) { pbegin.push_back(0); }
+};
+
+// Next-use index of the qubits of a circuit. Slices are identified by
+// their position in the original circuit. Queries must be done with a
+// non decreasing current slice: the cursor of each qubit only moves
+// forward, so that the cost of a query is O(1) amortized for a fixed
+// window.
+struct LookaheadIndex
+{
+  vector<QubitUses> uses;
+
+  void build(const Circuit& circuit);
+
+  bool isIndexed(const int qb) const;
+
+  // Moves the cursor of qb to the first use at slice >= slice
+  void advance(const int qb, const int slice);
+
+  // Returns the slice of the first use of qb after current_slice,
+  // numeric_limits<int>::max() if qb is not used anymore
+  int nextUse(const int qb, const int current_slice);
+
+  // Returns the remaining depth of the circuit after current_slice
+  // along the uses of qb, 0 if qb is not used anymore
+  int remainingDepth(const int qb, const int current_slice);
+
+  // Returns the affinity of qb with core_id in the window of slices
+  // (current_slice, current_slice + window]. Each partner of qb
+  // mapped on core_id in a use at slice s contributes with
+  // discount^(s - current_slice - 1). Partners in exclude are not
+  // considered.
+  double affinity(const int qb, const int core_id, const int current_slice,
+		  const int window, const double discount,
+		  const Mapping& mapping, const list<int>& exclude);
+};
+
+#endif
@@ -63,14 +63,13 @@ int main(int argc, char* argv[])
 
   // Update the quantum related parameters based on the qscale_factor
   parameters.scaleQuantumRelatedParameters();
+  architecture.buildCoreGateDelays(parameters.gate_delays, parameters.qscale_factor);
 
   // IMPORTANT: The following initializations go in this exact order -
   // Do not change order
   noc.initializeTokenOwnerMap();
-  cores.mapping.initMapping(circuit.number_of_qubits,
-			    architecture.number_of_cores,
-			    architecture.mapping_type, parameters.seed);
-  cores.initCores(architecture.number_of_cores, architecture.qubits_per_core);
+  cores.mapping.initMapping(circuit, architecture, parameters.seed);
+  cores.initCores(architecture.number_of_cores, architecture.core_qubits);
 
   
   // Display info: banner, commandline, circuit, architecture,
@@ -83,14 +82,51 @@ int main(int argc, char* argv[])
   architecture.display();
   parameters.display();
 
-  // Run simulation
+  // Run simulation. The lookahead destination selection is compared
+  // against the load-aware one and the rebalancing against no
+  // rebalancing on the same initial mapping.
   Simulation simulation;
+  Statistics ref_stats, ref_rebalance_stats;
+  if (architecture.dst_selection_mode == DST_SEL_LOOKAHEAD)
+    {
+      Architecture ref_architecture = architecture;
+      ref_architecture.dst_selection_mode = DST_SEL_LOAD_AWARE;
+      ref_stats = simulation.simulateReference(circuit, ref_architecture, noc, parameters,
+					       mapping, cores);
+    }
+
+  if (simulation.rebalancer.isEnabled(architecture))
+    {
+      Architecture ref_architecture = architecture;
+      ref_architecture.rebalance_interval = 0;
+      ref_architecture.rebalance_threshold = 0.0;
+      ref_rebalance_stats = simulation.simulateReference(circuit, ref_architecture, noc,
+							 parameters, mapping, cores);
+    }
+  
   Statistics stats = simulation.simulate(circuit, architecture, noc, parameters, mapping, cores);
 
+  if (architecture.dst_selection_mode == DST_SEL_LOOKAHEAD)
+    {
+      stats.reference_teleportations = ref_stats.getTotalTeleportations();
+      stats.reference_dst_selection_mode = DST_SEL_LOAD_AWARE;
+    }
+
+  if (simulation.rebalancer.isEnabled(architecture))
+    stats.reference_remote_gate_latency = ref_rebalance_stats.getRemoteGateLatency();
+
   // Display statistics
   simulation.display();
   
   stats.display(cores, architecture, parameters);
+
+  mapping.display();
+
+  // The final mapping can be used as the initial mapping of a
+  // subsequent run (mapping_type 3)
+  if (!architecture.mapping_output_file.empty() &&
+      !mapping.writeToFile(architecture.mapping_output_file, architecture.number_of_cores))
+    return ERR_FATAL;
   
   
   return 0;
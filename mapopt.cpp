@@ -0,0 +1,181 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: mapopt.cpp
+// Description: Standalone tool for the offline optimization of the
+//              initial qubit mapping
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <iostream>
+#include <cmath>
+#include <map>
+#include <thread>
+#include <algorithm>
+#include "utils.h"
+#include "architecture.h"
+#include "core.h"
+#include "circuit.h"
+#include "mapping.h"
+#include "noc.h"
+#include "parameters.h"
+#include "partitioning.h"
+#include "annealing.h"
+#include "command_line.h"
+
+using namespace std;
+
+
+bool checkCommandLine(int argc, char* argv[],
+		      string& circuitfn, string& architecturefn, string& parametersfn,
+		      string& mappingfn, double& time_budget, int& nreplicas,
+		      map<string,string>& params_override)
+{
+  params_override.clear();
+
+  for (int i=1; i<argc; i++)
+    {
+      string arg = argv[i];
+      if (i+1 >= argc)
+	return false; // every option has at least one value
+
+      if (arg == "-a")
+	architecturefn = string(argv[++i]);
+      else if (arg == "-c")
+	circuitfn = string(argv[++i]);
+      else if (arg == "-p")
+	parametersfn = string(argv[++i]);
+      else if (arg == "-m")
+	mappingfn = string(argv[++i]);
+      else if (arg == "-t")
+	time_budget = stod(argv[++i]);
+      else if (arg == "-r")
+	nreplicas = stoi(argv[++i]);
+      else if (arg == "-o" && i+2 < argc)
+	{
+	  params_override[string(argv[i+1])] = string(argv[i+2]);
+	  i += 2;
+	}
+      else
+	return false;
+    }
+
+  return (!circuitfn.empty() && !architecturefn.empty() &&
+	  !parametersfn.empty() && !mappingfn.empty());
+}
+
+int main(int argc, char* argv[])
+{
+  string circuit_fn, architecture_fn, parameters_fn, mapping_fn;
+  double time_budget = 10.0;
+  int nreplicas = max(4, (int)thread::hardware_concurrency());
+  map<string,string> params_override;
+
+  if (!checkCommandLine(argc, argv, circuit_fn, architecture_fn, parameters_fn,
+			mapping_fn, time_budget, nreplicas, params_override))
+    {
+      cerr << "Usage " << argv[0] << " -c <circuit> -a <architecture> -p <parameters> -m <output mapping>"
+	   << " [-t <time budget (sec)>] [-r <replicas>] [-o <param> <value>]" << endl;
+      return -1;
+    }
+
+  Circuit circuit;
+  if (!circuit.readFromFile(circuit_fn))
+    {
+      cerr << "Error reading circuit file " << circuit_fn << endl;
+      return ERR_CIRC_FILE;
+    }
+
+  NoC noc;
+  Mapping mapping;
+  Cores cores(mapping);
+  Architecture architecture(cores, noc);
+  if (!architecture.readFromFile(architecture_fn))
+    {
+      cerr << "Error reading architecture file " << architecture_fn << endl;
+      return ERR_ARCH_FILE;
+    }
+
+  Parameters parameters(noc);
+  if (!parameters.readFromFile(parameters_fn))
+    {
+      cerr << "Error reading parameters file " << parameters_fn << endl;
+      return ERR_PARM_FILE;
+    }
+
+  overrideParameters(params_override, architecture, parameters);
+  parameters.scaleQuantumRelatedParameters();
+
+  // The search starts from the mapping specified in the architecture
+  // file (mapping_type)
+  mapping.initMapping(circuit, architecture, parameters.seed);
+  cores.initCores(architecture.number_of_cores, architecture.core_qubits);
+
+  int nqubits = circuit.number_of_qubits;
+  vector<int> initial(nqubits);
+  int max_load = 0;
+  for (int qb = 0; qb < nqubits; qb++)
+    initial[qb] = mapping.qubit2CoreSafe(qb);
+  for (const auto& core : cores.cores)
+    max_load = max(max_load, (int)core.size());
+
+  // The cost model does not account for the occupancy of the cores,
+  // thus moves are bounded by the same imbalance allowed to the
+  // partitioner. Two slots are always left free, so that a remote
+  // gate can teleport a qubit in the least loaded core of the gate.
+  int ncores = architecture.number_of_cores;
+  int balanced_load = max((nqubits + ncores - 1) / ncores,
+			  (int)ceil((1.0 + architecture.partition_imbalance) * nqubits / ncores));
+  balanced_load = min(balanced_load, architecture.getMaxCoreCapacity() - 2);
+  max_load = max(max_load, balanced_load);
+
+  InteractionGraph graph;
+  graph.build(circuit, architecture.partition_decay);
+
+  double t_quantum = parameters.epr_delay + parameters.dist_delay +
+    parameters.pre_delay + parameters.post_delay;
+  int volume = ceil(log2(2 + architecture.total_physical_qubits));
+  MappingCostModel model(graph, noc, ncores, t_quantum, volume);
+
+  AnnealingOptimizer optimizer(model, ncores, max_load,
+			       max(1, nreplicas));
+
+  chrono::high_resolution_clock::time_point chrono_start;
+  startChrono(chrono_start);
+  vector<int> best = optimizer.optimize(initial, time_budget, parameters.seed);
+  double runtime = stopChrono(chrono_start);
+
+  for (int qb = 0; qb < nqubits; qb++)
+    mapping.qubit2core[qb] = best[qb];
+  if (architecture.isHeterogeneous())
+    mapping.fitCoreCapacity(mapping.qubit2core, architecture);
+
+  if (!mapping.writeToFile(mapping_fn, architecture.number_of_cores))
+    return ERR_FATAL;
+
+  showBanner();
+  showCommandLine(argc, argv);
+
+  cout << endl
+       << "Optimization:" << endl
+       << IND << "circuit: '" << circuit_fn << "'" << endl
+       << IND << "number_of_qubits: " << nqubits << endl
+       << IND << "number_of_cores: " << architecture.number_of_cores << endl
+       << IND << "max_qubits_per_core: " << max_load << endl
+       << IND << "seed: " << parameters.seed << endl
+       << IND << "replicas: " << optimizer.nreplicas << endl
+       << IND << "time_budget: " << time_budget << " # sec" << endl
+       << IND << "runtime: " << runtime << " # sec" << endl
+       << IND << "epochs: " << optimizer.epochs << endl
+       << IND << "accepted_moves: " << optimizer.accepted_moves << endl
+       << IND << "replica_exchanges: " << optimizer.exchanges << endl
+       << IND << "initial_cost: " << optimizer.initial_cost << " # sec" << endl
+       << IND << "best_cost: " << optimizer.best_cost << " # sec" << endl
+       << IND << "cost_reduction: "
+       << ((optimizer.initial_cost > 0.0) ?
+	   100.0 * (optimizer.initial_cost - optimizer.best_cost) / optimizer.initial_cost : 0.0)
+       << " # %" << endl
+       << IND << "mapping_file: '" << mapping_fn << "'" << endl;
+
+  return 0;
+}
@@ -13,35 +13,69 @@
 #include <cstdlib>
 #include <random>
 #include <algorithm>
+#include <fstream>
+#include <cstdint>
+#include <yaml-cpp/yaml.h>
 #include "utils.h"
 #include "mapping.h"
+#include "circuit.h"
+#include "architecture.h"
+#include "partitioning.h"
 
 
-void Mapping::initMapping(const int nqubits, const int ncores,
-			  const int mapping_type, const unsigned seed)
+void Mapping::initMapping(const Circuit& circuit, const Architecture& architecture,
+			  const unsigned seed)
 {
+  int nqubits = circuit.number_of_qubits;
+  int ncores = architecture.number_of_cores;
+  int mapping_type = architecture.mapping_type;
+
   if (mapping_type == MAP_SEQUENTIAL)
     qubit2core = this->sequentialMapping(nqubits, ncores);
   else if (mapping_type == MAP_RANDOM)
     qubit2core = this->randomMapping(nqubits, ncores, seed);
+  else if (mapping_type == MAP_PARTITION)
+    qubit2core = this->partitionMapping(circuit, architecture, seed);
+  else if (mapping_type == MAP_FILE)
+    qubit2core = this->fileMapping(circuit, architecture);
   else {
     ostringstream oss;
     oss << "Invalid mapping type.";
     FATAL(oss.str());
   }
+
+  if (mapping_type != MAP_FILE)
+    fitCoreCapacity(qubit2core, architecture);
+
+  initial_qubit2core = qubit2core;
 }
 
-void Mapping::display()
+static void displayQubit2Core(const map<int,int>& q2c)
 {
-  cout << endl
-       << "*** Mapping ***" << endl;
-  
-  int nqb = qubit2core.size();    
-  for (int qb=0; qb<nqb; qb++)
+  cout << "[";
+  bool first = true;
+  for (const auto& kv : q2c)
     {
-      assert(isMapped(qb));
-      cout << "qubit " << qb << " -> core " << qubit2core[qb] << endl;
+      if (kv.first < 0) // ancillas are not displayed
+	continue;
+      if (!first)
+	cout << ", ";
+      cout << kv.second;
+      first = false;
     }
+  cout << "]" << endl;
+}
+
+void Mapping::display()
+{
+  cout << endl
+       << "Mapping:" << endl;
+
+  cout << IND << "initial_qubit2core: ";
+  displayQubit2Core(initial_qubit2core);
+
+  cout << IND << "final_qubit2core: ";
+  displayQubit2Core(qubit2core);
 }
 
 map<int,int> Mapping::sequentialMapping(const int nqubits, const int ncores)
@@ -80,6 +114,302 @@ map<int,int> Mapping::randomMapping(const int nqubits, const int ncores,
   return mapping;
 }
 
+map<int,int> Mapping::partitionMapping(const Circuit& circuit,
+				       const Architecture& architecture,
+				       const unsigned seed)
+{
+  int nqubits = circuit.number_of_qubits;
+  int ncores = architecture.number_of_cores;
+
+  if (nqubits > architecture.total_physical_qubits)
+    {
+      ostringstream oss;
+      oss << "The circuit requires " << nqubits << " qubits but the architecture provides "
+	  << architecture.total_physical_qubits << " physical qubits.";
+      FATAL(oss.str());
+    }
+
+  // The weight of each part is bounded by the core capacity and by
+  // the allowed imbalance with respect to a perfectly balanced
+  // partition
+  int balanced_weight = (nqubits + ncores - 1) / ncores;
+  int max_part_weight = ceil((1.0 + architecture.partition_imbalance) * nqubits / ncores);
+  max_part_weight = max(max_part_weight, balanced_weight);
+  max_part_weight = min(max_part_weight, architecture.getMaxCoreCapacity());
+
+  // Mesh distance is taken into account only for mesh teleportation
+  const NoC* noc = nullptr;
+  if (architecture.partition_mesh_aware && architecture.teleportation_type == TP_TYPE_MESH)
+    noc = &architecture.noc;
+
+  InteractionGraph graph;
+  graph.build(circuit, architecture.partition_decay);
+
+  Partitioner partitioner(ncores, max_part_weight, noc, seed);
+  vector<int> part = partitioner.partition(graph);
+
+  map<int,int> q2c;
+  for (int qb = 0; qb < nqubits; qb++)
+    q2c[qb] = part[qb];
+
+  // The parts are bounded by the largest core only, and by nothing if
+  // the balancing fails: the qubits exceeding the capacity of their
+  // core are moved to the nearest cores
+  vector<int> weights(ncores, 0);
+  for (int p : part)
+    weights[p]++;
+  for (int c = 0; c < ncores; c++)
+    if (weights[c] > architecture.getCoreCapacity(c))
+      {
+	fitCoreCapacity(q2c, architecture);
+	break;
+      }
+
+  return q2c;
+}
+
+void Mapping::fitCoreCapacity(map<int,int>& q2c, const Architecture& architecture)
+{
+  int ncores = architecture.number_of_cores;
+
+  vector<vector<int> > qubits(ncores);
+  for (const auto& kv : q2c)
+    qubits[kv.second].push_back(kv.first);
+
+  for (int core = 0; core < ncores; core++)
+    while ((int)qubits[core].size() > architecture.getCoreCapacity(core))
+      {
+	int target = -1;
+	for (int c = 0; c < ncores; c++)
+	  if ((int)qubits[c].size() < architecture.getCoreCapacity(c) &&
+	      (target == -1 || architecture.noc.getHopDistance(core, c) <
+	       architecture.noc.getHopDistance(core, target)))
+	    target = c;
+
+	if (target == -1)
+	  {
+	    ostringstream oss;
+	    oss << "The circuit requires " << q2c.size() << " qubits but the architecture provides "
+		<< architecture.total_physical_qubits << " physical qubits.";
+	    FATAL(oss.str());
+	  }
+
+	int qb = qubits[core].back();
+	qubits[core].pop_back();
+	qubits[target].push_back(qb);
+	q2c[qb] = target;
+      }
+}
+
+map<int,int> Mapping::fileMapping(const Circuit& circuit, const Architecture& architecture)
+{
+  int nqubits = circuit.number_of_qubits;
+  int ncores = architecture.number_of_cores;
+  const string& file_name = architecture.mapping_file;
+
+  int file_ncores;
+  if (!readFromFile(file_name, file_ncores))
+    {
+      ostringstream oss;
+      oss << "Error reading mapping file '" << file_name << "'.";
+      FATAL(oss.str());
+    }
+
+  if (file_ncores != ncores)
+    {
+      ostringstream oss;
+      oss << "Mapping file '" << file_name << "' is for " << file_ncores
+	  << " cores, while the architecture has " << ncores << " cores.";
+      FATAL(oss.str());
+    }
+
+  map<int,int> q2c;
+  vector<int> load(ncores, 0);
+  for (int qb = 0; qb < nqubits; qb++)
+    if (isMapped(qb))
+      {
+	q2c[qb] = qubit2core[qb];
+	load[q2c[qb]]++;
+      }
+
+  for (int qb = 0; qb < nqubits; qb++)
+    if (q2c.find(qb) == q2c.end())
+      {
+	int core = min_element(load.begin(), load.end()) - load.begin();
+	q2c[qb] = core;
+	load[core]++;
+      }
+
+  for (int core = 0; core < ncores; core++)
+    if (load[core] > architecture.getCoreCapacity(core))
+      {
+	ostringstream oss;
+	oss << "Mapping file '" << file_name << "' maps " << load[core]
+	    << " qubits on core " << core << " whose capacity is "
+	    << architecture.getCoreCapacity(core) << " qubits.";
+	FATAL(oss.str());
+      }
+
+  return q2c;
+}
+
+bool Mapping::readFromFile(const string& file_name, int& ncores)
+{
+  ifstream in(file_name, ios::binary);
+  uint32_t magic = 0;
+  if (in.is_open() && in.read((char*)&magic, sizeof(magic)) && magic == MAPPING_BINARY_MAGIC)
+    return readFromBinaryFile(file_name, ncores);
+  in.close();
+
+  YAML::Node config;
+  if (!loadYAMLFile(file_name, config))
+    return false;
+
+  int nqubits;
+  vector<int> q2c;
+  bool result = true;
+  result &= getOrFail<int>(config, "number_of_qubits", file_name, nqubits);
+  result &= getOrFail<int>(config, "number_of_cores", file_name, ncores);
+  result &= getOrFail<vector<int> >(config, "qubit2core", file_name, q2c);
+  if (!result)
+    return false;
+
+  if ((int)q2c.size() != nqubits)
+    {
+      cerr << "Error: 'qubit2core' must have number_of_qubits elements in " << file_name << endl;
+      return false;
+    }
+
+  qubit2core.clear();
+  for (int qb = 0; qb < nqubits; qb++)
+    {
+      if (q2c[qb] < 0 || q2c[qb] >= ncores)
+	{
+	  cerr << "Error: invalid core " << q2c[qb] << " for qubit " << qb
+	       << " in " << file_name << endl;
+	  return false;
+	}
+      qubit2core[qb] = q2c[qb];
+    }
+
+  return true;
+}
+
+bool Mapping::writeToFile(const string& file_name, const int ncores) const
+{
+  const string ext = ".bin";
+  if (file_name.size() > ext.size() &&
+      file_name.compare(file_name.size() - ext.size(), ext.size(), ext) == 0)
+    return writeToBinaryFile(file_name, ncores);
+
+  ofstream out(file_name);
+  if (!out.is_open())
+    {
+      cerr << "Error: cannot open file '" << file_name << "'" << endl;
+      return false;
+    }
+
+  int nqubits = numberOfQubits();
+
+  out << "number_of_qubits: " << nqubits << endl
+      << "number_of_cores: " << ncores << endl
+      << "qubit2core: [";
+  for (int qb = 0; qb < nqubits; qb++)
+    {
+      out << qubit2CoreSafe(qb);
+      if (qb != nqubits-1)
+	out << ", ";
+    }
+  out << "]" << endl;
+
+  return true;
+}
+
+bool Mapping::readFromBinaryFile(const string& file_name, int& ncores)
+{
+  ifstream in(file_name, ios::binary);
+  if (!in.is_open())
+    {
+      cerr << "Error: cannot open file '" << file_name << "'" << endl;
+      return false;
+    }
+
+  uint32_t magic;
+  int32_t header[2];
+  in.read((char*)&magic, sizeof(magic));
+  in.read((char*)header, sizeof(header));
+  if (!in || magic != MAPPING_BINARY_MAGIC || header[0] < 0 || header[1] <= 0)
+    {
+      cerr << "Error: invalid header in " << file_name << endl;
+      return false;
+    }
+
+  int nqubits = header[0];
+  ncores = header[1];
+  vector<uint16_t> q2c(nqubits);
+  in.read((char*)q2c.data(), nqubits * sizeof(uint16_t));
+  if (!in)
+    {
+      cerr << "Error: " << file_name << " is truncated" << endl;
+      return false;
+    }
+
+  qubit2core.clear();
+  for (int qb = 0; qb < nqubits; qb++)
+    {
+      if (q2c[qb] >= ncores)
+	{
+	  cerr << "Error: invalid core " << q2c[qb] << " for qubit " << qb
+	       << " in " << file_name << endl;
+	  return false;
+	}
+      qubit2core[qb] = q2c[qb];
+    }
+
+  return true;
+}
+
+bool Mapping::writeToBinaryFile(const string& file_name, const int ncores) const
+{
+  ofstream out(file_name, ios::binary);
+  if (!out.is_open())
+    {
+      cerr << "Error: cannot open file '" << file_name << "'" << endl;
+      return false;
+    }
+
+  if (ncores > UINT16_MAX + 1)
+    {
+      cerr << "Error: the binary mapping format supports up to " << UINT16_MAX + 1
+	   << " cores" << endl;
+      return false;
+    }
+
+  int nqubits = numberOfQubits();
+  uint32_t magic = MAPPING_BINARY_MAGIC;
+  int32_t header[2] = { nqubits, ncores };
+  vector<uint16_t> q2c(nqubits);
+  for (int qb = 0; qb < nqubits; qb++)
+    q2c[qb] = qubit2CoreSafe(qb);
+
+  out.write((const char*)&magic, sizeof(magic));
+  out.write((const char*)header, sizeof(header));
+  out.write((const char*)q2c.data(), nqubits * sizeof(uint16_t));
+
+  return (bool)out;
+}
+
+int Mapping::numberOfQubits() const
+{
+  // ancillas have negative ids
+  int nqubits = 0;
+  for (const auto& kv : qubit2core)
+    if (kv.first >= 0)
+      nqubits++;
+
+  return nqubits;
+}
+
 bool Mapping::isMapped(const int qb) const
 {
   return (qubit2core.find(qb) != qubit2core.end());
@@ -10,21 +10,33 @@
 #define __MAPPING_H__
 
 #include <map>
+#include <string>
 
 #define MAP_RANDOM     0
 #define MAP_SEQUENTIAL 1
+#define MAP_PARTITION  2
+#define MAP_FILE       3
 
 using namespace std;
 
+struct Circuit;
+struct Architecture;
+
+// Magic number at the beginning of a binary mapping file
+#define MAPPING_BINARY_MAGIC 0x50414d51 // "QMAP"
+
 struct Mapping
 {
   map<int,int> qubit2core; // Indicates where a qubit is mapped onto which core
+  map<int,int> initial_qubit2core; // Mapping at the start of the simulation
   
   Mapping() {}
 
-  void initMapping(const int nqubits, const int ncores,
-		   const int mapping_type, const unsigned seed);
+  void initMapping(const Circuit& circuit, const Architecture& architecture,
+		   const unsigned seed);
 
+  // Displays the initial and the current mapping of the circuit
+  // qubits
   void display();
 
   map<int,int> sequentialMapping(const int nqubits, const int ncores);
@@ -33,6 +45,49 @@ struct Mapping
   map<int,int> randomMapping(const int nqubits, const int ncores,
 			     const unsigned seed);
 
+  // Partitions the qubit interaction graph of the circuit into
+  // number_of_cores parts in such a way the weight of the
+  // interactions between qubits mapped on different cores is
+  // minimized (see partitioning.h)
+  map<int,int> partitionMapping(const Circuit& circuit,
+				const Architecture& architecture,
+				const unsigned seed);
+
+  // Moves the qubits exceeding the capacity of a core (see
+  // Architecture::core_overrides) to the nearest cores with free
+  // qubits. The last qubits of a core are moved first
+  void fitCoreCapacity(map<int,int>& q2c, const Architecture& architecture);
+
+  // Loads the mapping from file (MAP_FILE). The mapping may come from
+  // a run on a different circuit on the same architecture (warm
+  // start): qubits not in the circuit are discarded and qubits not in
+  // the file are assigned to the least loaded cores. The load of each
+  // core is checked against its capacity.
+  map<int,int> fileMapping(const Circuit& circuit, const Architecture& architecture);
+
+  // Reads the mapping from a YAML file with the following keys:
+  //   number_of_qubits: <n>
+  //   number_of_cores: <k>
+  //   qubit2core: [<core of qubit 0>, ..., <core of qubit n-1>]
+  // or from a binary file (see writeToBinaryFile). The format is
+  // detected from the content of the file.
+  // Returns true if success, false otherwise
+  bool readFromFile(const string& file_name, int& ncores);
+
+  // Writes the mapping of the circuit qubits (ancillas are not
+  // included) in the format read by readFromFile. The binary format
+  // is used if the file name ends with ".bin"
+  bool writeToFile(const string& file_name, const int ncores) const;
+
+  // Binary format (native endianness): magic, number of qubits and
+  // number of cores as 32 bit integers followed by the core of each
+  // qubit as a 16 bit integer
+  bool readFromBinaryFile(const string& file_name, int& ncores);
+  bool writeToBinaryFile(const string& file_name, const int ncores) const;
+
+  // Number of mapped circuit qubits (ancillas are not counted)
+  int numberOfQubits() const;
+
   bool isMapped(const int qb) const;
   int qubit2CoreSafe(const int qb) const;
 };
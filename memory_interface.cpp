@@ -0,0 +1,187 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: memory_interface.cpp
+// Description: Implementation of the memory interfaces dispatching the
+//              instructions to the cores
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <iostream>
+#include <algorithm>
+#include <tuple>
+#include "utils.h"
+#include "memory_interface.h"
+
+// ----------------------------------------------------------------------
+void MemoryInterfaces::build(const NoC& noc)
+{
+  int ncores = noc.number_of_cores;
+
+  if (placement == MI_PLACE_LIST)
+    {
+      if (core_list.empty())
+	FATAL("mi_cores is empty");
+      cores = core_list;
+    }
+  else
+    {
+      if (number < 1 || number > ncores)
+	FATAL("memory_interfaces must be in [1, number_of_cores]");
+
+      if (noc.topology_type == TOPO_MESH || noc.topology_type == TOPO_TORUS)
+	placeOnGrid(noc);
+      else
+	{
+	  cores.clear();
+	  for (int i = 0; i < number; i++)
+	    cores.push_back(i * ncores / number);
+	}
+    }
+
+  for (int c : cores)
+    if (c < 0 || c >= ncores)
+      FATAL("memory interface attached to core " + to_string(c) + " out of range");
+
+  assignCores(noc);
+}
+
+// ----------------------------------------------------------------------
+void MemoryInterfaces::placeOnGrid(const NoC& noc)
+{
+  int nx = noc.mesh_x, ny = noc.mesh_y;
+  cores.clear();
+
+  if (placement == MI_PLACE_CORNER)
+    {
+      if (number > 4)
+	FATAL("at most 4 memory interfaces can be placed at the corners");
+
+      // opposite corners first
+      int corners[4] = { noc.getCoreID(0, 0), noc.getCoreID(nx-1, ny-1),
+			 noc.getCoreID(nx-1, 0), noc.getCoreID(0, ny-1) };
+      cores.assign(corners, corners + number);
+    }
+  else if (placement == MI_PLACE_CENTER)
+    {
+      // cores sorted by (twice) their distance from the center
+      vector<tuple<int,int> > by_distance;
+      for (int c = 0; c < nx * ny; c++)
+	{
+	  int x, y;
+	  noc.getCoreXY(c, x, y);
+	  int dx = 2 * x - (nx - 1), dy = 2 * y - (ny - 1);
+	  by_distance.push_back(make_tuple(dx * dx + dy * dy, c));
+	}
+      sort(by_distance.begin(), by_distance.end());
+
+      for (int i = 0; i < number; i++)
+	cores.push_back(get<1>(by_distance[i]));
+    }
+  else if (placement == MI_PLACE_EDGE)
+    {
+      // MI i is the (i / 4)-th of the edge i % 4 (west, east, north,
+      // south)
+      for (int i = 0; i < number; i++)
+	{
+	  int edge = i % 4;
+	  int on_edge = number / 4 + ((edge < number % 4) ? 1 : 0);
+	  int length = (edge < 2) ? ny : nx;
+	  int pos = (2 * (i / 4) + 1) * length / (2 * on_edge);
+
+	  if (edge == 0)
+	    cores.push_back(noc.getCoreID(0, pos));
+	  else if (edge == 1)
+	    cores.push_back(noc.getCoreID(nx-1, pos));
+	  else if (edge == 2)
+	    cores.push_back(noc.getCoreID(pos, 0));
+	  else
+	    cores.push_back(noc.getCoreID(pos, ny-1));
+	}
+    }
+  else
+    FATAL("undefined mi_placement");
+}
+
+// ----------------------------------------------------------------------
+void MemoryInterfaces::assignCores(const NoC& noc)
+{
+  int ncores = noc.number_of_cores;
+  int nmis = cores.size();
+  mi_of_core.assign(ncores, -1);
+
+  if (assignment == MI_ASSIGN_NEAREST)
+    {
+      for (int c = 0; c < ncores; c++)
+	for (int i = 0; i < nmis; i++)
+	  if (mi_of_core[c] == -1 ||
+	      noc.getHopDistance(cores[i], c) < noc.getHopDistance(cores[mi_of_core[c]], c))
+	    mi_of_core[c] = i;
+    }
+  else if (assignment == MI_ASSIGN_PARTITIONED)
+    {
+      // (MI, core) pairs by increasing distance. A core is assigned
+      // to the first MI not saturated.
+      vector<tuple<int,int,int> > pairs;
+      for (int c = 0; c < ncores; c++)
+	for (int i = 0; i < nmis; i++)
+	  pairs.push_back(make_tuple(noc.getHopDistance(cores[i], c), i, c));
+      sort(pairs.begin(), pairs.end());
+
+      int capacity = (ncores + nmis - 1) / nmis;
+      vector<int> served(nmis, 0);
+      for (const auto& p : pairs)
+	{
+	  int i = get<1>(p), c = get<2>(p);
+	  if (mi_of_core[c] == -1 && served[i] < capacity)
+	    {
+	      mi_of_core[c] = i;
+	      served[i]++;
+	    }
+	}
+    }
+  else
+    FATAL("undefined mi_assignment");
+}
+
+// ----------------------------------------------------------------------
+double MemoryInterfaces::getTransferTime(const NoC& noc, const int volume) const
+{
+  if (bandwidth > 0.0)
+    return volume / bandwidth;
+
+  return noc.getTransferTime(volume);
+}
+
+// ----------------------------------------------------------------------
+void MemoryInterfaces::display() const
+{
+  cout << IND << "memory_interfaces:" << endl
+       << IND << IND << "number: " << cores.size() << endl
+       << IND << IND << "placement: " << placement;
+
+  if (placement == MI_PLACE_CORNER)
+    cout << " # corner" << endl;
+  else if (placement == MI_PLACE_CENTER)
+    cout << " # center" << endl;
+  else if (placement == MI_PLACE_EDGE)
+    cout << " # edge" << endl;
+  else if (placement == MI_PLACE_LIST)
+    cout << " # list" << endl;
+  else
+    cout << " # ??\?" << endl;
+
+  cout << IND << IND << "cores: [";
+  for (unsigned int i = 0; i < cores.size(); i++)
+    cout << (i > 0 ? ", " : "") << cores[i];
+  cout << "]" << endl;
+
+  cout << IND << IND << "bandwidth: " << bandwidth << " # bps (0 = NoC link)" << endl
+       << IND << IND << "assignment: " << assignment;
+  if (assignment == MI_ASSIGN_NEAREST)
+    cout << " # nearest" << endl;
+  else if (assignment == MI_ASSIGN_PARTITIONED)
+    cout << " # partitioned" << endl;
+  else
+    cout << " # ??\?" << endl;
+}
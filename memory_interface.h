@@ -0,0 +1,67 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: memory_interface.h
+// Description: Declaration of the memory interfaces dispatching the
+//              instructions to the cores
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __MEMORY_INTERFACE_H__
+#define __MEMORY_INTERFACE_H__
+
+#include <vector>
+#include "noc.h"
+
+using namespace std;
+
+#define MI_PLACE_CORNER 0
+#define MI_PLACE_CENTER 1
+#define MI_PLACE_EDGE   2
+#define MI_PLACE_LIST   3
+
+#define MI_ASSIGN_NEAREST     0
+#define MI_ASSIGN_PARTITIONED 1
+
+// The instructions are fetched by the memory interfaces (MIs). Each
+// MI is attached to a core and dispatches the instructions of the
+// cores assigned to it. The MIs are placed according to placement:
+// - MI_PLACE_CORNER: at the corners of the mesh (at most 4);
+// - MI_PLACE_CENTER: at the cores nearest to the center of the mesh;
+// - MI_PLACE_EDGE: along the edges of the mesh, in turn west, east,
+//   north and south, evenly spaced on each edge;
+// - MI_PLACE_LIST: at the cores in core_list.
+// With the topologies other than mesh and torus the MIs are evenly
+// spaced by core id (but MI_PLACE_LIST). A core is served by the
+// nearest MI (MI_ASSIGN_NEAREST) or by the nearest MI with less than
+// ceil(cores / MIs) cores (MI_ASSIGN_PARTITIONED).
+struct MemoryInterfaces
+{
+  int         number; // ignored with MI_PLACE_LIST
+  int         placement;
+  vector<int> core_list; // used with MI_PLACE_LIST
+  double      bandwidth; // bps of the link between a MI and its core (0 = NoC link)
+  int         assignment;
+
+  // Derived values
+  vector<int> cores; // cores[i] is the core MI i is attached to
+  vector<int> mi_of_core; // MI serving each core
+
+  MemoryInterfaces() : number(1), placement(MI_PLACE_CORNER), bandwidth(0.0),
+		       assignment(MI_ASSIGN_NEAREST) {}
+
+  // Places the MIs on the cores of noc and assigns the cores to them
+  void build(const NoC& noc);
+
+  int getNumMIs() const { return cores.size(); }
+
+  // Time for transferring volume bits from a MI to its core
+  double getTransferTime(const NoC& noc, const int volume) const;
+
+  void display() const;
+
+  void placeOnGrid(const NoC& noc);
+  void assignCores(const NoC& noc);
+};
+
+#endif
@@ -9,9 +9,13 @@
 #include <iostream>
 #include <cmath>
 #include <cassert>
+#include <limits>
 #include <algorithm>
+#include <functional>
+#include <tuple>
 #include "utils.h"
 #include "noc.h"
+#include "wormhole.h"
 
 
 
@@ -20,11 +24,94 @@ void NoC::display()
   if (!winoc)
     {
       cout << IND << "NoC:" << endl
-	   << IND << IND << "mesh_size: '" << mesh_x << "x" << mesh_y << "'" << endl
-	   << IND << IND << "clock_period: " << clock_time << " # sec" << endl
-	   << IND << IND << "link_width: " << link_width << " # bits" << endl;
+	   << IND << IND << "topology: " << topology_type;
+
+      if (topology_type == TOPO_MESH)
+	cout << " # mesh" << endl;
+      else if (topology_type == TOPO_TORUS)
+	cout << " # torus" << endl;
+      else if (topology_type == TOPO_RING)
+	cout << " # ring" << endl;
+      else if (topology_type == TOPO_CMESH)
+	cout << " # concentrated mesh" << endl;
+      else if (topology_type == TOPO_CLUSTER)
+	cout << " # cluster" << endl;
+      else if (topology_type == TOPO_FILE)
+	cout << " # file" << endl;
+      else
+	cout << " # ??\?" << endl;
+
+      if (topology_type == TOPO_FILE)
+	cout << IND << IND << "topology_file: '" << topology_file << "'" << endl;
+      else
+	cout << IND << IND << "mesh_size: '" << mesh_x << "x" << mesh_y << "'" << endl;
+
+      if (topology_type == TOPO_CMESH || topology_type == TOPO_CLUSTER)
+	cout << IND << IND << "concentration: " << concentration << endl;
+      if (topology_type == TOPO_CLUSTER)
+	cout << IND << IND << "global_link_latency: " << global_link_latency << " # cycles" << endl;
+
+      if (topology_type != TOPO_MESH)
+	{
+	  cout << IND << IND << "number_of_cores: " << number_of_cores << endl
+	       << IND << IND << "routes: " << topology.routes;
+	  if (topology.routes == ROUTES_SHORTEST)
+	    cout << " # shortest path" << endl;
+	  else if (topology.routes == ROUTES_DIMENSION_ORDER)
+	    cout << " # dimension order, dateline VC classes" << endl;
+	  else if (topology.routes == ROUTES_UP_DOWN)
+	    cout << " # up*/down*" << endl;
+	  else
+	    cout << " # ??\?" << endl;
+	}
+
+      cout << IND << IND << "clock_period: " << clock_time << " # sec" << endl
+	   << IND << IND << "link_width: " << link_width << " # bits" << endl
+	   << IND << IND << "flow_control: " << flow_control;
+
+      if (flow_control == FLOW_STORE_AND_FORWARD)
+	cout << " # store and forward" << endl;
+      else if (flow_control == FLOW_WORMHOLE)
+	cout << " # wormhole" << endl
+	     << IND << IND << "router_pipeline: " << router_pipeline << " # cycles" << endl
+	     << IND << IND << "buffer_depth: " << buffer_depth << " # flits" << endl
+	     << IND << IND << "virtual_channels: " << virtual_channels << endl;
+      else
+	cout << " # ??\?" << endl;
+
+      if (topology_type == TOPO_MESH)
+	{
+	  cout << IND << IND << "routing_algorithm: " << routing_algorithm;
+	  if (routing_algorithm == ROUTING_XY)
+	    cout << " # xy" << endl;
+	  else if (routing_algorithm == ROUTING_YX)
+	    cout << " # yx" << endl;
+	  else if (routing_algorithm == ROUTING_O1TURN)
+	    cout << " # o1turn" << endl;
+	  else if (routing_algorithm == ROUTING_ODD_EVEN)
+	    cout << " # odd-even" << endl;
+	  else if (routing_algorithm == ROUTING_WEST_FIRST)
+	    cout << " # west-first" << endl;
+	  else
+	    cout << " # ??\?" << endl;
+	}
+
+      cout << IND << IND << "hybrid_mode: " << hybrid_mode;
+      if (hybrid_mode == HYBRID_OFF)
+	cout << " # wired only" << endl;
+      else if (hybrid_mode == HYBRID_DISTANCE)
+	cout << " # distance" << endl
+	     << IND << IND << "hybrid_hop_threshold: " << hybrid_hop_threshold << " # hops" << endl;
+      else if (hybrid_mode == HYBRID_VOLUME)
+	cout << " # volume" << endl
+	     << IND << IND << "hybrid_volume_threshold: " << hybrid_volume_threshold << " # bits" << endl;
+      else if (hybrid_mode == HYBRID_LOAD)
+	cout << " # load" << endl;
+      else
+	cout << " # ??\?" << endl;
     }
-  else
+
+  if (winoc || hybrid_mode != HYBRID_OFF)
     {
       cout << IND << "WiNoC:" << endl
 	   << IND << IND << "bit_rate: " << wbit_rate << " # bps" << endl
@@ -39,6 +126,13 @@ void NoC::display()
       else
 	cout << " # ??\?" << endl;
     }
+
+  cout << IND << IND << "packet_header_bits: " << packet_header_bits << endl
+       << IND << IND << "coalescing: " << (coalescing ? "true" : "false") << endl;
+  if (coalescing)
+    cout << IND << IND << "max_packet_bits: " << max_packet_bits << " # 0 = no limit" << endl;
+  cout << IND << IND << "multicast: " << (multicast ? "true" : "false") << endl
+       << IND << IND << "qlink_channels: " << qlink_channels << " # 0 = constant EPR delays" << endl;
 }
 
 
@@ -110,11 +204,16 @@ int NoC::nextClockCycle(const map<pair<int,int>, queue<pair<int,int> > >& links_
 
 bool NoC::updateLinksOccupation(map<pair<int,int>, queue<pair<int,int>, deque<pair<int,int>>>>& links_occupation,
 				const int cid, Communication& comm,
-				const int clock_cycle) const
+				const int clock_cycle, const int src_core,
+				map<int,int>& next_hops) const
 {
   bool drained = false;
-  
-  int next_core = routingXY(comm.src_core, comm.dst_core);
+
+  auto it_next_hop = next_hops.find(cid);
+  if (it_next_hop == next_hops.end())
+    it_next_hop = next_hops.insert(make_pair(cid, routing(comm.src_core, src_core, comm.dst_core,
+							  cid, &links_occupation))).first;
+  int next_core = it_next_hop->second;
 
   pair<int,int> link(comm.src_core, next_core);
 
@@ -124,7 +223,7 @@ bool NoC::updateLinksOccupation(map<pair<int,int>, queue<pair<int,int>, deque<pa
     {
       // comm_id is the first one traversing the link
       queue<pair<int,int> > q;
-      q.push(pair<int,int>(cid, clock_cycle + linkTraversalCycles(comm.volume)));
+      q.push(pair<int,int>(cid, clock_cycle + linkTraversalCycles(comm.src_core, next_core, comm.volume)));
       links_occupation[link] = q;
     }
   else
@@ -140,7 +239,8 @@ bool NoC::updateLinksOccupation(map<pair<int,int>, queue<pair<int,int>, deque<pa
 	  // previous communications left the link
 	  it_links_occupation->second.push(pair<int,int>(cid,
 							 computeStartTime(it_links_occupation->second) +
-							 linkTraversalCycles(comm.volume)));	  
+							 linkTraversalCycles(comm.src_core, next_core, comm.volume)));	  
+	  max_link_queue = max(max_link_queue, (int)it_links_occupation->second.size());
 	}
       else
 	{
@@ -151,9 +251,10 @@ bool NoC::updateLinksOccupation(map<pair<int,int>, queue<pair<int,int>, deque<pa
 	      clock_cycle >= it_links_occupation->second.front().second)
 	    {
 	      comm.src_core = next_core;
+	      next_hops.erase(it_next_hop);
 
-	      // check if drained
-	      if (comm.src_core == comm.dst_core)
+	      // check if drained (multicasts are drained by forkMulticast)
+	      if (comm.src_core == comm.dst_core && !comm.isMulticast())
 		drained = true;
 
 	      // remove the communication from the queue of the current link
@@ -169,10 +270,32 @@ bool NoC::updateLinksOccupation(map<pair<int,int>, queue<pair<int,int>, deque<pa
   return drained;
 }
 
+double NoC::getCommunicationTimeWormhole(const ParallelCommunications& pcomms) const
+{
+  WormholeNetwork network(*this);
+  vector<long> latencies;
+  long cycles = network.simulate(expandMulticasts(pcomms), latencies);
+
+  for (long l : latencies)
+    {
+      packets++;
+      packet_latency_cycles += l;
+    }
+
+  return cycles * clock_time;
+}
+
 double NoC::getCommunicationTimeWired(const ParallelCommunications& pcomms) const
 {
+  if (flow_control == FLOW_WORMHOLE)
+    return getCommunicationTimeWormhole(pcomms);
+
   map<pair<int,int>, queue<pair<int,int>, deque<pair<int,int>>>> links_occupation; // links_occupation[(node1,node2)] --> queue of pairs (comm_id, when the link is released)
   map<int,Communication> pcomms_id = assignCommunicationIds(pcomms);
+  map<int,int> next_hops;
+  vector<int> src_cores;
+  for (const auto& comm : pcomms)
+    src_cores.push_back(comm.src_core);
   int clock_cycle = 0;
   
   while (!pcomms_id.empty())
@@ -181,7 +304,16 @@ double NoC::getCommunicationTimeWired(const ParallelCommunications& pcomms) cons
       
       for (map<int,Communication>::iterator it = pcomms_id.begin(); it != pcomms_id.end(); )
 	{
-	  bool drained = updateLinksOccupation(links_occupation, it->first, it->second, clock_cycle);
+	  if (it->second.isMulticast() && next_hops.find(it->first) == next_hops.end() &&
+	      forkMulticast(links_occupation, it->first, pcomms_id, clock_cycle,
+			    src_cores, next_hops))
+	    {
+	      it = pcomms_id.erase(it);
+	      continue;
+	    }
+
+	  bool drained = updateLinksOccupation(links_occupation, it->first, it->second, clock_cycle,
+					       src_cores[it->first], next_hops);
 	  /* DEBUG
 	  cout << "\tcomm id " << it->first << ": " << it->second.src_core << "-->" << it->second.dst_core << " (" << it->second.volume << ")" << endl;
 	  cout << "\tlinks occupation:" << endl;
@@ -200,7 +332,11 @@ double NoC::getCommunicationTimeWired(const ParallelCommunications& pcomms) cons
 	  */
 	  
 	  if (drained)
-	    it = pcomms_id.erase(it);
+	    {
+	      packets++;
+	      packet_latency_cycles += clock_cycle;
+	      it = pcomms_id.erase(it);
+	    }
 	  else
 	    ++it;
 	}
@@ -212,10 +348,195 @@ double NoC::getCommunicationTimeWired(const ParallelCommunications& pcomms) cons
   return clock_cycle * clock_time;
 }
 
+bool NoC::forkMulticast(map<pair<int,int>, queue<pair<int,int>, deque<pair<int,int>>>>& links_occupation,
+			const int cid, map<int,Communication>& pcomms_id,
+			const int clock_cycle, vector<int>& src_cores,
+			map<int,int>& next_hops) const
+{
+  Communication& comm = pcomms_id.at(cid);
+  int current = comm.src_core;
+  int shared = comm.getSharedVolume();
+
+  // Destinations grouped by next hop (the first group is kept by
+  // cid). next_core[g] is the next hop of group g.
+  vector<int> next_core;
+  vector<vector<int> > dsts, dst_vols;
+  for (unsigned int i = 0; i < comm.dst_cores.size(); i++)
+    {
+      int dst = comm.dst_cores[i];
+      if (dst == current)
+	{
+	  packets++;
+	  packet_latency_cycles += clock_cycle;
+	  continue;
+	}
+
+      int nc = routing(current, src_cores[cid], dst, cid, &links_occupation);
+      unsigned int g = find(next_core.begin(), next_core.end(), nc) - next_core.begin();
+      if (g == next_core.size())
+	{
+	  next_core.push_back(nc);
+	  dsts.push_back(vector<int>());
+	  dst_vols.push_back(vector<int>());
+	}
+      dsts[g].push_back(dst);
+      dst_vols[g].push_back(comm.dst_volumes[i]);
+    }
+
+  if (next_core.empty())
+    return true;
+
+  // New ids follow all the ids used so far, thus the forked
+  // communications are visited later in the same clock cycle
+  for (unsigned int g = 1; g < next_core.size(); g++)
+    {
+      int fid = src_cores.size();
+      pcomms_id.insert(make_pair(fid, Communication(current, dsts[g], dst_vols[g], shared)));
+      src_cores.push_back(src_cores[cid]);
+      next_hops[fid] = next_core[g];
+    }
+
+  comm = Communication(current, dsts[0], dst_vols[0], shared);
+  next_hops[cid] = next_core[0];
+
+  return false;
+}
+
+ParallelCommunications NoC::expandMulticasts(const ParallelCommunications& pcomms) const
+{
+  ParallelCommunications unicasts;
+
+  for (const auto& comm : pcomms)
+    if (!comm.isMulticast())
+      unicasts.push_back(comm);
+    else
+      for (unsigned int i = 0; i < comm.dst_cores.size(); i++)
+	if (comm.dst_cores[i] != comm.src_core)
+	  unicasts.push_back(Communication(comm.src_core, comm.dst_cores[i],
+					   comm.getSharedVolume() + comm.dst_volumes[i]));
+
+  return unicasts;
+}
+
+void NoC::selectMedium(const ParallelCommunications& pcomms,
+		       ParallelCommunications& wired,
+		       ParallelCommunications& wireless) const
+{
+  // HYBRID_LOAD: cycles booked on the links and time booked on the
+  // radio channels by the communications already assigned, and
+  // communications of each core assigned to the radio channels
+  map<pair<int,int>, int> link_load;
+  vector<double> channel_time(radio_channels, 0.0);
+  map<int,int> radio_comms;
+
+  for (const auto& comm : pcomms)
+    {
+      vector<int> dsts = comm.isMulticast() ? comm.dst_cores : vector<int>(1, comm.dst_core);
+      int hops = 0;
+      for (int dst : dsts)
+	hops = max(hops, getHopDistance(comm.src_core, dst));
+
+      bool radio = false;
+      if (hops == 0)
+	radio = false; // local
+      else if (hybrid_mode == HYBRID_DISTANCE)
+	radio = (hops >= hybrid_hop_threshold);
+      else if (hybrid_mode == HYBRID_VOLUME)
+	radio = (comm.volume >= hybrid_volume_threshold);
+      else if (hybrid_mode == HYBRID_LOAD)
+	{
+	  // store-and-forward estimate: the most loaded link of the
+	  // path delays the communication
+	  vector<vector<int> > paths;
+	  int wired_cycles = 0;
+	  for (int dst : dsts)
+	    {
+	      paths.push_back(getPath(comm.src_core, dst, 0));
+	      const vector<int>& path = paths.back();
+	      int max_load = 0, cycles = 0;
+	      for (unsigned int i = 1; i < path.size(); i++)
+		{
+		  max_load = max(max_load, link_load[make_pair(path[i-1], path[i])]);
+		  cycles += linkTraversalCycles(path[i-1], path[i], comm.volume);
+		}
+	      wired_cycles = max(wired_cycles, max_load + cycles);
+	    }
+
+	  // token passing estimate: the WI waits for the token of a
+	  // channel, a full round for each of its previous
+	  // communications
+	  int rc_best = 0;
+	  double t_wireless = 0.0;
+	  for (int rc = 0; rc < radio_channels; rc++)
+	    {
+	      int steps = (comm.src_core - token_owner_map[rc] + number_of_cores) % number_of_cores
+		+ radio_comms[comm.src_core] * number_of_cores / radio_channels;
+	      double t = max(channel_time[rc], steps * token_pass_time) + comm.volume / wbit_rate;
+	      if (rc == 0 || t < t_wireless)
+		{
+		  rc_best = rc;
+		  t_wireless = t;
+		}
+	    }
+	  radio = (t_wireless < wired_cycles * clock_time);
+
+	  if (radio)
+	    {
+	      channel_time[rc_best] = t_wireless;
+	      radio_comms[comm.src_core]++;
+	    }
+	  else
+	    for (const auto& path : paths)
+	      for (unsigned int i = 1; i < path.size(); i++)
+		link_load[make_pair(path[i-1], path[i])] +=
+		  linkTraversalCycles(path[i-1], path[i], comm.volume);
+	}
+      else
+	FATAL("undefined hybrid_mode");
+
+      if (radio)
+	wireless.push_back(comm);
+      else
+	wired.push_back(comm);
+    }
+}
+
+double NoC::getCommunicationTimeHybrid(const ParallelCommunications& pcomms) const
+{
+  ParallelCommunications wired, wireless;
+  selectMedium(pcomms, wired, wireless);
+
+  double t_wired = getCommunicationTimeWired(wired);
+  double t_wireless = wireless.empty() ? 0.0 : getCommunicationTimeWireless(wireless);
+
+  wired_traffic.messages += wired.size();
+  wired_traffic.volume += getTotalCommunicationVolume(wired);
+  wired_traffic.time += t_wired;
+  wireless_traffic.messages += wireless.size();
+  wireless_traffic.volume += getTotalCommunicationVolume(wireless);
+  wireless_traffic.time += t_wireless;
+
+  return max(t_wired, t_wireless);
+}
+
+void NoC::resetTrafficStats() const
+{
+  packets = 0;
+  packet_latency_cycles = 0;
+  max_link_queue = 0;
+  wired_traffic = MediumTraffic();
+  wireless_traffic = MediumTraffic();
+}
+
+double NoC::getAvgPacketLatency() const
+{
+  return (packets == 0) ? 0.0 : (double)packet_latency_cycles / packets;
+}
+
 void NoC::initializeTokenOwnerMap()
 {
   token_owner_map.resize(radio_channels);
-  int ncores = mesh_x * mesh_y;
+  int ncores = number_of_cores;
   int step = ncores / radio_channels;
   int core_id = 0;
   for (int rc=0; rc < radio_channels; rc++)
@@ -240,7 +561,7 @@ void NoC::advanceTokensAndUpdateTimeLine(vector<double>& timeline) const
   for (int rc=0; rc < radio_channels; rc++)
     {
       // advance token to the next core in sequence
-      token_owner_map[rc] = (token_owner_map[rc] + 1) % (mesh_x * mesh_y);
+      token_owner_map[rc] = (token_owner_map[rc] + 1) % number_of_cores;
 
       // update the timeline with token_pass_time
       timeline[rc] += token_pass_time;
@@ -291,8 +612,9 @@ double NoC::getCommunicationTimeWirelessToken(const ParallelCommunications& pcom
 	    curr++;
 	  }
 	else {
-	  // update the timeline associated to radio channel rc
-	  timeline[rc] += getTransferTime(curr->volume);
+	  // update the timeline associated to radio channel rc (the
+	  // hybrid NoC uses it with winoc false)
+	  timeline[rc] += curr->volume / wbit_rate;
 
 	  // remove communication from the list of parallel
 	  // communications
@@ -322,9 +644,85 @@ double NoC::getCommunicationTimeWireless(const ParallelCommunications& pcomms) c
   return -1; // dummy return
 }
 
+ParallelCommunications NoC::packetize(const ParallelCommunications& pcomms) const
+{
+  return packetize(pcomms, coalescing);
+}
+
+ParallelCommunications NoC::packetize(const ParallelCommunications& pcomms,
+				      const bool merge) const
+{
+  ParallelCommunications packets;
+
+  // Packets are emitted in the order of the first message of each
+  // pair. open[(src,dst)] is the packet being filled. Multicasts are
+  // never merged.
+  map<pair<int,int>, ParallelCommunications::iterator> open;
+  for (const auto& comm : pcomms)
+    {
+      if (!merge || comm.isMulticast())
+	{
+	  packets.push_back(comm);
+	  packets.back().volume += packet_header_bits;
+	  continue;
+	}
+
+      pair<int,int> key(comm.src_core, comm.dst_core);
+      auto it = open.find(key);
+      if (it != open.end() &&
+	  (max_packet_bits <= 0 || it->second->volume + comm.volume <= max_packet_bits))
+	it->second->volume += comm.volume;
+      else
+	{
+	  packets.push_back(Communication(comm.src_core, comm.dst_core,
+					  comm.volume + packet_header_bits));
+	  open[key] = prev(packets.end());
+	}
+    }
+
+  return packets;
+}
+
+double NoC::getUncoalescedCommunicationTime(const ParallelCommunications& pcomms) const
+{
+  NoCState saved = saveState();
+
+  double t = getCommunicationTime(packetize(pcomms, false));
+
+  restoreState(saved);
+
+  return t;
+}
+
+NoCState NoC::saveState() const
+{
+  NoCState state;
+
+  state.token_owner_map = token_owner_map;
+  state.packets = packets;
+  state.packet_latency_cycles = packet_latency_cycles;
+  state.max_link_queue = max_link_queue;
+  state.wired_traffic = wired_traffic;
+  state.wireless_traffic = wireless_traffic;
+
+  return state;
+}
+
+void NoC::restoreState(const NoCState& state) const
+{
+  token_owner_map = state.token_owner_map;
+  packets = state.packets;
+  packet_latency_cycles = state.packet_latency_cycles;
+  max_link_queue = state.max_link_queue;
+  wired_traffic = state.wired_traffic;
+  wireless_traffic = state.wireless_traffic;
+}
+
 double NoC::getCommunicationTime(const ParallelCommunications& pcomms) const
 {
-  if (!winoc)
+  if (!winoc && hybrid_mode != HYBRID_OFF)
+    return getCommunicationTimeHybrid(pcomms);
+  else if (!winoc)
     return getCommunicationTimeWired(pcomms);
   else
     return getCommunicationTimeWireless(pcomms);  
@@ -338,11 +736,331 @@ double NoC::getTransferTime(int volume) const
     return volume / wbit_rate;
 }
 
+void NoC::getEPRDistributionTime(const ParallelCommunications& pcomms, const bool swapping,
+				 double& t_epr, double& t_dist) const
+{
+  double t_gen = 1.0 / qlink_epr_rate;
+  vector<vector<int> > paths;
+  for (const auto& comm : pcomms)
+    paths.push_back(getPath(comm.src_core, comm.dst_core, paths.size()));
+
+  // Each step holds a channel of the link. A pair is generated where
+  // a segment starts.
+  auto startsSegment = [&](const vector<int>& path, const int hop) {
+    return (hop == 0 || (swapping && path[hop] < number_of_cores));
+  };
+
+  double generated = 0.0;
+  double completed =
+    reserveLinks(paths, qlink_channels, startsSegment,
+		 [](const vector<int>&, const int, const double t) { return t; },
+		 [&](const vector<int>& path, const int hop, const double start, const int latency) {
+		   double duration = qlink_hop_delay * latency;
+		   if (startsSegment(path, hop))
+		     {
+		       duration += t_gen;
+		       generated = max(generated, start + t_gen);
+		     }
+		   return duration;
+		 });
+
+  t_epr = generated;
+  t_dist = completed - generated;
+}
+
+double NoC::getShuttlingTime(const ParallelCommunications& pcomms) const
+{
+  vector<vector<int> > paths;
+  for (const auto& comm : pcomms)
+    paths.push_back(getPath(comm.src_core, comm.dst_core, paths.size()));
+
+  // An ion holds a slot of the segment and waits for the junctions of
+  // the intermediate nodes: junctions[node] --> when the junction is
+  // released
+  map<int,double> junctions;
+
+  return reserveLinks(paths, shuttle_capacity,
+		      [](const vector<int>&, const int hop) { return hop == 0; },
+		      [&](const vector<int>& path, const int hop, const double t) {
+			if (hop == 0)
+			  return t;
+			double& junction = junctions[path[hop]];
+			junction = max(t, junction) + shuttle_junction_time;
+			return junction;
+		      },
+		      [&](const vector<int>&, const int, const double, const int latency) {
+			return shuttle_segment_time * latency;
+		      });
+}
+
+double NoC::reserveLinks(const vector<vector<int> >& paths, const int slots,
+			 const function<bool(const vector<int>&, int)>& starts,
+			 const function<double(const vector<int>&, int, double)>& enter,
+			 const function<double(const vector<int>&, int, double, int)>& hold) const
+{
+  // links[(node1,node2)] --> when each slot of the link is released
+  map<pair<int,int>, vector<double> > links;
+
+  // events: (time, path, hop). The path is ready to be extended over
+  // its hop-th link at time.
+  priority_queue<tuple<double,int,int>, vector<tuple<double,int,int> >,
+		 greater<tuple<double,int,int> > > events;
+  for (unsigned int i = 0; i < paths.size(); i++)
+    for (unsigned int hop = 0; hop + 1 < paths[i].size(); hop++)
+      if (starts(paths[i], hop))
+	events.push(make_tuple(0.0, i, hop));
+
+  double completed = 0.0;
+  while (!events.empty())
+    {
+      double t = get<0>(events.top());
+      int    pid = get<1>(events.top());
+      int    hop = get<2>(events.top());
+      events.pop();
+
+      const vector<int>& path = paths[pid];
+      if (hop == (int)path.size() - 1 || (hop > 0 && starts(path, hop)))
+	{
+	  completed = max(completed, t);
+	  continue;
+	}
+
+      t = enter(path, hop, t);
+
+      int a = min(path[hop], path[hop+1]), b = max(path[hop], path[hop+1]);
+      vector<double>& link = links[make_pair(a, b)];
+      if (link.empty())
+	link.assign(slots, 0.0);
+
+      // first slot released
+      auto slot = min_element(link.begin(), link.end());
+      double start = max(t, *slot);
+      const Link* l = topology.getLink(a, b);
+      *slot = start + hold(path, hop, start, l == nullptr ? 1 : l->latency);
+      events.push(make_tuple(*slot, pid, hop + 1));
+    }
+
+  return completed;
+}
+
 int NoC::linkTraversalCycles(int volume) const
 {
   return ceil((double)volume/link_width);
 }
 
+int NoC::linkTraversalCycles(const int node_a, const int node_b, int volume) const
+{
+  const Link* link = topology.getLink(node_a, node_b);
+  if (link == nullptr)
+    return linkTraversalCycles(volume); // mesh link
+
+  // the first flit takes latency cycles, the others follow one per
+  // cycle
+  return link->latency - 1 + (int)ceil((double)volume/link->width);
+}
+
+void NoC::buildTopology()
+{
+  bool connected = true;
+
+  if (topology_type == TOPO_MESH)
+    {
+      number_of_cores = mesh_x * mesh_y;
+      topology.clear(number_of_cores, number_of_cores);
+      return; // routed by routing_algorithm
+    }
+  else if (topology_type == TOPO_TORUS)
+    topology.buildMesh(mesh_x, mesh_y, link_width, true);
+  else if (topology_type == TOPO_RING)
+    topology.buildRing(mesh_x * mesh_y, link_width);
+  else if (topology_type == TOPO_CMESH)
+    topology.buildConcentratedMesh(mesh_x, mesh_y, concentration, link_width);
+  else if (topology_type == TOPO_CLUSTER)
+    topology.buildCluster(mesh_x * mesh_y, concentration, link_width, global_link_latency);
+  else if (topology_type == TOPO_FILE)
+    {
+      if (!topology.readFromFile(topology_file, link_width))
+	FATAL("Error reading topology file '" + topology_file + "'");
+    }
+  else
+    FATAL("undefined topology");
+
+  number_of_cores = topology.number_of_cores;
+  connected = topology.computeRoutingTables(flow_control == FLOW_WORMHOLE);
+  if (!connected)
+    FATAL("The topology is not connected");
+}
+
+int NoC::getVCClasses() const
+{
+  if (topology_type != TOPO_MESH)
+    return topology.vc_classes;
+
+  return (routing_algorithm == ROUTING_O1TURN) ? 2 : 1;
+}
+
+int NoC::getVCClass(const int node, const int dst_core, const int packet_id) const
+{
+  if (topology_type != TOPO_MESH)
+    return topology.vc_class[node][dst_core];
+
+  return (routing_algorithm == ROUTING_O1TURN) ? packet_id % 2 : 0;
+}
+
+int NoC::routing(const int current_core, const int src_core, const int dst_core,
+		 const int packet_id, const LinksOccupation* links_occupation) const
+{
+  if (topology_type != TOPO_MESH)
+    return topology.next_hop[current_core][dst_core];
+  else if (routing_algorithm == ROUTING_XY)
+    return routingXY(current_core, dst_core);
+  else if (routing_algorithm == ROUTING_YX)
+    return routingYX(current_core, dst_core);
+  else if (routing_algorithm == ROUTING_O1TURN)
+    return (packet_id % 2 == 0) ?
+      routingXY(current_core, dst_core) : routingYX(current_core, dst_core);
+  else if (routing_algorithm == ROUTING_ODD_EVEN)
+    return selectOutput(current_core, routingOddEven(current_core, src_core, dst_core),
+			links_occupation);
+  else if (routing_algorithm == ROUTING_WEST_FIRST)
+    return selectOutput(current_core, routingWestFirst(current_core, dst_core),
+			links_occupation);
+  else
+    FATAL("undefined routing_algorithm");
+
+  return -1; // dummy return
+}
+
+int NoC::selectOutput(const int current_core, const vector<int>& outputs,
+		      const LinksOccupation* links_occupation) const
+{
+  assert(!outputs.empty());
+
+  int selected = outputs.front();
+  if (links_occupation == nullptr)
+    return selected;
+
+  size_t min_queue = numeric_limits<size_t>::max();
+  for (int next_core : outputs)
+    {
+      auto it = links_occupation->find(make_pair(current_core, next_core));
+      size_t queue_size = (it == links_occupation->end()) ? 0 : it->second.size();
+      if (queue_size < min_queue)
+	{
+	  min_queue = queue_size;
+	  selected = next_core;
+	}
+    }
+
+  return selected;
+}
+
+bool NoC::areNeighbors(const int core_a, const int core_b) const
+{
+  vector<int> path = getPath(core_a, core_b, 0);
+  for (size_t i = 1; i + 1 < path.size(); i++)
+    if (path[i] < number_of_cores)
+      return false;
+
+  return (core_a != core_b);
+}
+
+vector<int> NoC::getPath(const int src_core, const int dst_core, const int packet_id) const
+{
+  vector<int> path(1, src_core);
+
+  while (path.back() != dst_core)
+    path.push_back(routing(path.back(), src_core, dst_core, packet_id, nullptr));
+
+  return path;
+}
+
+int NoC::routingYX(const int src_core, const int dst_core) const
+{
+  int x, y, xd, yd;
+  
+  getCoreXY(src_core, x, y);
+  getCoreXY(dst_core, xd, yd);
+
+  if (y < yd)
+    y++;
+  else if (y > yd)
+    y--;
+  else if (x < xd)
+    x++;
+  else if (x > xd)
+    x--;
+
+  return getCoreID(x, y);
+}
+
+// Odd-even turn model (G.-M. Chiu, 2000): east-north and east-south
+// turns are forbidden in even columns, north-west and south-west
+// turns in odd columns. X outputs come first.
+vector<int> NoC::routingOddEven(const int current_core, const int src_core,
+				const int dst_core) const
+{
+  int xc, yc, xs, ys, xd, yd;
+
+  getCoreXY(current_core, xc, yc);
+  getCoreXY(src_core, xs, ys);
+  getCoreXY(dst_core, xd, yd);
+
+  int dx = xd - xc;
+  int dy = yd - yc;
+  int y_next = (dy > 0) ? yc + 1 : yc - 1;
+  vector<int> outputs;
+
+  if (dx == 0)
+    outputs.push_back(getCoreID(xc, y_next));
+  else if (dx > 0)
+    {
+      if (dy == 0)
+	outputs.push_back(getCoreID(xc + 1, yc));
+      else
+	{
+	  if (xd % 2 == 1 || dx != 1)
+	    outputs.push_back(getCoreID(xc + 1, yc));
+	  if (xc % 2 == 1 || xc == xs)
+	    outputs.push_back(getCoreID(xc, y_next));
+	}
+    }
+  else
+    {
+      outputs.push_back(getCoreID(xc - 1, yc));
+      if (dy != 0 && xc % 2 == 0)
+	outputs.push_back(getCoreID(xc, y_next));
+    }
+
+  return outputs;
+}
+
+// West-first turn model: packets directed west are routed west
+// first, the others adaptively among east and north/south. X outputs
+// come first.
+vector<int> NoC::routingWestFirst(const int current_core, const int dst_core) const
+{
+  int xc, yc, xd, yd;
+
+  getCoreXY(current_core, xc, yc);
+  getCoreXY(dst_core, xd, yd);
+
+  vector<int> outputs;
+  if (xd < xc)
+    outputs.push_back(getCoreID(xc - 1, yc));
+  else
+    {
+      if (xd > xc)
+	outputs.push_back(getCoreID(xc + 1, yc));
+      if (yd > yc)
+	outputs.push_back(getCoreID(xc, yc + 1));
+      else if (yd < yc)
+	outputs.push_back(getCoreID(xc, yc - 1));
+    }
+
+  return outputs;
+}
+
 int NoC::routingXY(const int src_core, const int dst_core) const
 {
   int x, y, xd, yd;
@@ -372,3 +1090,16 @@ int NoC::getCoreID(const int x, const int y) const
 {
   return y * mesh_x + x;
 }
+
+int NoC::getHopDistance(const int src_core, const int dst_core) const
+{
+  if (topology_type != TOPO_MESH)
+    return topology.hops[src_core][dst_core];
+
+  int xs, ys, xd, yd;
+
+  getCoreXY(src_core, xs, ys);
+  getCoreXY(dst_core, xd, yd);
+
+  return abs(xs - xd) + abs(ys - yd);
+}
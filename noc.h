@@ -9,20 +9,73 @@
 #ifndef __NOC_H__
 #define __NOC_H__
 
+#include <functional>
 #include <map>
 #include <queue>
 #include <vector>
 #include "communication.h"
+#include "topology.h"
 
 using namespace std;
 
 #define WIRELESS_MAC_TOKEN 0
 #define WIRELESS_MAC_LPT   1
 
+#define ROUTING_XY         0
+#define ROUTING_YX         1
+#define ROUTING_O1TURN     2
+#define ROUTING_ODD_EVEN   3
+#define ROUTING_WEST_FIRST 4
+
+#define FLOW_STORE_AND_FORWARD 0
+#define FLOW_WORMHOLE          1
+
+// Medium of each communication of the hybrid NoC (wired NoC with
+// wireless interfaces)
+#define HYBRID_OFF      0 // wired only
+#define HYBRID_DISTANCE 1 // wireless if hops >= hybrid_hop_threshold
+#define HYBRID_VOLUME   2 // wireless if volume >= hybrid_volume_threshold
+#define HYBRID_LOAD     3 // medium with the earliest estimated completion
+
+// links_occupation[(node1,node2)] --> queue of pairs (comm_id, when
+// the link is released)
+typedef map<pair<int,int>, queue<pair<int,int> > > LinksOccupation;
+
+// Traffic sent over a medium of the hybrid NoC. time is the sum of
+// the communication times of the medium.
+struct MediumTraffic
+{
+  long   messages;
+  long   volume;
+  double time;
+
+  MediumTraffic() : messages(0), volume(0), time(0.0) {}
+};
+
+// State of the NoC modified by the communications
+struct NoCState
+{
+  vector<int> token_owner_map;
+  long packets;
+  long packet_latency_cycles;
+  int  max_link_queue;
+  MediumTraffic wired_traffic;
+  MediumTraffic wireless_traffic;
+};
+
 struct NoC
 {
   int    mesh_x, mesh_y;
   int    link_width;
+  int    topology_type;
+  string topology_file; // used with TOPO_FILE
+  int    concentration; // cores per router (TOPO_CMESH) or per cluster (TOPO_CLUSTER)
+  int    global_link_latency; // cycles of the links between clusters (TOPO_CLUSTER)
+  int    number_of_cores; // derived value
+
+  // Graph and routing tables of the topologies other than TOPO_MESH
+  Topology topology;
+
   double clock_time;
   int    qubit_addr_bits;
   double wbit_rate;
@@ -30,12 +83,80 @@ struct NoC
   double token_pass_time;
   int    wireless_mac;
   bool   winoc;
+  int    routing_algorithm;
+
+  // Flow control of the wired NoC. With FLOW_WORMHOLE the NoC is
+  // simulated at flit level (see wormhole.h)
+  int    flow_control;
+  int    router_pipeline; // cycles spent by a flit in a router
+  int    buffer_depth; // flits per virtual channel
+  int    virtual_channels; // per input port
+
+  // Packets of the classical messages. Each packet carries a header
+  // of packet_header_bits. With coalescing, messages between the same
+  // pair of cores sent together are merged in packets of at most
+  // max_packet_bits (0 = no limit).
+  bool   coalescing;
+  int    packet_header_bits;
+  int    max_packet_bits;
+
+  // Multicast communications. In the wired NoC a multicast is forked
+  // where the routes to its destinations diverge (a tree rooted at
+  // the source). In the WiNoC it is a single broadcast transmission.
+  bool   multicast;
+
+  // Quantum links used to distribute the EPR pairs of the
+  // teleportations. They follow the links of the NoC and each one has
+  // qlink_channels parallel EPR channels. With qlink_channels = 0 the
+  // generation and the distribution of the EPR pairs take the
+  // constant epr_delay and dist_delay (see Parameters).
+  int    qlink_channels;
+  double qlink_epr_rate; // pairs/sec generated by a channel
+  double qlink_hop_delay; // sec to extend a pair over a link (x link latency)
+
+  // Shuttling of the ions (TP_TYPE_SHUTTLE). The links of the NoC are
+  // segments holding at most shuttle_capacity ions at once, the
+  // nodes are junctions crossed by one ion at a time.
+  int    shuttle_capacity;
+  double shuttle_segment_time; // sec to traverse a segment (x link latency)
+  double shuttle_junction_time; // sec to cross a junction
+
+  // Wired traffic routed so far: packets, sum of their latencies and
+  // max number of packets queued on a link
+  mutable long packets;
+  mutable long packet_latency_cycles;
+  mutable int  max_link_queue;
+
+  // Hybrid NoC (wireless_enabled false): each communication is sent
+  // over the mesh or over a radio channel according to hybrid_mode.
+  // The two mediums work concurrently.
+  int    hybrid_mode;
+  int    hybrid_hop_threshold; // HYBRID_DISTANCE
+  int    hybrid_volume_threshold; // HYBRID_VOLUME, in bits
+  mutable MediumTraffic wired_traffic;
+  mutable MediumTraffic wireless_traffic;
 
   // token_owner_map[rc] gives the core_id enabled to use the radio
   // channel rc
   mutable vector<int> token_owner_map; 
   
-  NoC() {}
+  NoC() : topology_type(TOPO_MESH), concentration(4), global_link_latency(2),
+	  number_of_cores(0), routing_algorithm(ROUTING_XY),
+	  flow_control(FLOW_STORE_AND_FORWARD), router_pipeline(1), buffer_depth(4),
+	  virtual_channels(2), coalescing(false), packet_header_bits(0), max_packet_bits(0),
+	  multicast(false), qlink_channels(0), qlink_epr_rate(1e6), qlink_hop_delay(0.01e-9),
+	  shuttle_capacity(1), shuttle_segment_time(20e-6), shuttle_junction_time(100e-6),
+	  packets(0),
+	  packet_latency_cycles(0), max_link_queue(0), hybrid_mode(HYBRID_OFF),
+	  hybrid_hop_threshold(3), hybrid_volume_threshold(64) {}
+
+  // Builds the topology from topology_type and the related attributes
+  // and computes number_of_cores
+  void buildTopology();
+
+  void resetTrafficStats() const;
+
+  double getAvgPacketLatency() const; // in clock cycles
 
 
   // Initialize token_owner_map (tom) in such a way tokens are equally
@@ -59,6 +180,22 @@ struct NoC
   // Display NoC/WiNoC information to the stdout in YAML format
   void display();
 
+  // Returns the packets carrying the messages in pcomms: the headers
+  // are added and, with coalescing, messages with the same source and
+  // destination are merged (a message is never split)
+  ParallelCommunications packetize(const ParallelCommunications& pcomms) const;
+  ParallelCommunications packetize(const ParallelCommunications& pcomms,
+				   const bool merge) const;
+
+  // Communication time of pcomms with a packet per message. The
+  // state of the NoC (tokens and traffic statistics) is not modified.
+  double getUncoalescedCommunicationTime(const ParallelCommunications& pcomms) const;
+
+  // Saves and restores the state modified by getCommunicationTime
+  // (tokens and traffic statistics)
+  NoCState saveState() const;
+  void restoreState(const NoCState& state) const;
+
   // Computes the communication time for the set of parallel
   // communications. This is the main function that invokes the
   // appropriate getCommunicationTime method for NoC or WiNoC
@@ -68,6 +205,19 @@ struct NoC
   // communications for the wired NoC.
   double getCommunicationTimeWired(const ParallelCommunications& pc) const;
 
+  // Same as above for the hybrid NoC: max of the times of the two
+  // mediums
+  double getCommunicationTimeHybrid(const ParallelCommunications& pc) const;
+
+  // Splits pcomms between the mesh and the radio channels according
+  // to hybrid_mode
+  void selectMedium(const ParallelCommunications& pcomms,
+		    ParallelCommunications& wired,
+		    ParallelCommunications& wireless) const;
+
+  // Same as above with the flit-level wormhole model
+  double getCommunicationTimeWormhole(const ParallelCommunications& pc) const;
+
   // Computes the communication time for the set of parallel
   // communications for the WiNoC. This is the main function which
   // calls the appropriate getCommunicationTimeWireless based on the
@@ -90,9 +240,84 @@ struct NoC
   // (transmission time), then assign to channel with min current load
   double getCommunicationTimeWirelessLTP(const ParallelCommunications& pcomms) const; 
 
+  // Computes the EPR pair generation (t_epr) and distribution
+  // (t_dist) times of the teleportations in pcomms over the quantum
+  // links (event driven, first come first served). A pair is
+  // generated on the first link of the path from the source to the
+  // destination core (1/qlink_epr_rate) and then extended link by
+  // link (qlink_hop_delay x link latency). Each step holds a channel
+  // of the link. t_epr is the time the last pair is generated and
+  // t_dist the time to complete the distribution after that. With
+  // swapping, the segments of the path between two cores are
+  // distributed in parallel, each with its own pair, to be joined by
+  // entanglement swapping at the intermediate cores.
+  void getEPRDistributionTime(const ParallelCommunications& pcomms, const bool swapping,
+			      double& t_epr, double& t_dist) const;
+
+  // Returns the time to shuttle the qubits of pcomms from the source
+  // to the destination core along the path of the NoC (event driven,
+  // first come first served). An ion waits for a free slot of the
+  // next segment and for the junctions of the intermediate nodes.
+  double getShuttlingTime(const ParallelCommunications& pcomms) const;
+
+  // Moves the paths over their links, event driven and first come
+  // first served, starting from each hop where starts(path, hop)
+  // holds up to the next one or to the destination. Each step takes
+  // the first released of the slots of the link (undirected): it
+  // waits until enter(path, hop, t), the time the hop-th node lets go
+  // what arrived at t, and holds the slot for hold(path, hop, start,
+  // latency), where latency is the one of the link. Returns the time
+  // the last step completes.
+  double reserveLinks(const vector<vector<int> >& paths, const int slots,
+		      const function<bool(const vector<int>&, int)>& starts,
+		      const function<double(const vector<int>&, int, double)>& enter,
+		      const function<double(const vector<int>&, int, double, int)>& hold) const;
+
+  // Returns the next node of a packet in current_core, injected in
+  // src_core and directed to dst_core. With TOPO_MESH the packet is
+  // routed according to routing_algorithm, otherwise through the
+  // routing table of the topology. All the algorithms are minimal.
+  // The adaptive ones (odd-even and west-first) select among the
+  // admissible outputs the link with the fewest packets queued in
+  // links_occupation (the first admissible output if links_occupation
+  // is nullptr). O1TURN routes the packets with an even id XY and the
+  // others YX.
+  int routing(const int current_core, const int src_core, const int dst_core,
+	      const int packet_id, const LinksOccupation* links_occupation) const;
+
+  // Number of VC classes the routes need to be deadlock-free with
+  // the wormhole flow control and VC class of the hop of packet_id
+  // from node toward dst_core. The VCs of an input port are split
+  // among the classes, VC v belonging to class v % classes. O1TURN
+  // routes the XY packets in class 0 and the YX ones in class 1, the
+  // topologies other than TOPO_MESH use the classes of their routing
+  // tables (see topology.h).
+  int getVCClasses() const;
+  int getVCClass(const int node, const int dst_core, const int packet_id) const;
+
   // XY routing algorithm
   int routingXY(const int src_core, const int dst_core) const;
 
+  // YX routing algorithm
+  int routingYX(const int src_core, const int dst_core) const;
+
+  // Admissible outputs of the odd-even and west-first turn models
+  vector<int> routingOddEven(const int current_core, const int src_core,
+			     const int dst_core) const;
+  vector<int> routingWestFirst(const int current_core, const int dst_core) const;
+
+  // Selects the output with the shortest link queue
+  int selectOutput(const int current_core, const vector<int>& outputs,
+		   const LinksOccupation* links_occupation) const;
+
+  // Returns the nodes traversed from src_core to dst_core (both
+  // included) with no other traffic in the NoC
+  vector<int> getPath(const int src_core, const int dst_core, const int packet_id) const;
+
+  // Returns true if the path between the two cores does not traverse
+  // other cores
+  bool areNeighbors(const int core_a, const int core_b) const;
+
   // Returns x and y coordinates of core core_id into the 2D mesh
   void getCoreXY(const int core_id, int& x, int& y) const;
 
@@ -100,10 +325,17 @@ struct NoC
   // the 2D mesh
   int getCoreID(const int x, const int y) const;
 
+  // Returns the number of hops between src_core and dst_core
+  int getHopDistance(const int src_core, const int dst_core) const;
+
   // Returns the number of cycles spent to transfer volume bits in a
   // NoC link
   int linkTraversalCycles(int volume) const;
 
+  // Same as above for the link from node_a to node_b, which may have
+  // its own width and latency
+  int linkTraversalCycles(const int node_a, const int node_b, int volume) const;
+
   // Returns the time to transfers volume bits in a NoC link or in a
   // radio channel based on the value of winoc attribute.
   double getTransferTime(int volume) const;
@@ -126,15 +358,35 @@ struct NoC
 
   // This method is used by getCommunicationTimeWired to update the
   // status of the NoC link in terms of their occupancy at a specific
-  // clock cycle
+  // clock cycle. The next core of a communication is selected when it
+  // is queued on a link and is kept in next_hops until it traverses
+  // the link. src_core is the core the communication has been
+  // injected in.
   bool updateLinksOccupation(map<pair<int,int>, queue<pair<int,int> > >& links_occupation,
 			     const int cid, Communication& comm,
-			     const int clock_cycle) const;
+			     const int clock_cycle, const int src_core,
+			     map<int,int>& next_hops) const;
 
   // This method is used by getCommunicationTimeWired do determine the
   // next clock cycle which is computed as the minimum waiting time in
   // the links_occupation structure
   int nextClockCycle(const map<pair<int,int>, queue<pair<int,int> > >& links_occupation) const;
+
+  // This method is used by getCommunicationTimeWired when the
+  // multicast cid is at a node and has not been routed yet. The
+  // message is delivered if the node is a destination, and the
+  // remaining destinations are grouped by next hop: the first group
+  // is kept by cid and a new communication is forked for each other
+  // group. Each branch carries only the bits addressed to its
+  // destinations. Returns true if no destination is left.
+  bool forkMulticast(map<pair<int,int>, queue<pair<int,int> > >& links_occupation,
+		     const int cid, map<int,Communication>& pcomms_id,
+		     const int clock_cycle, vector<int>& src_cores,
+		     map<int,int>& next_hops) const;
+
+  // Replaces each multicast with a unicast per destination carrying
+  // the shared part of the message and the part addressed to it
+  ParallelCommunications expandMulticasts(const ParallelCommunications& pcomms) const;
 };
 
 #endif
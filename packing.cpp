@@ -0,0 +1,156 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: packing.cpp
+// Description: Implementation of the policies packing remote gates into
+//              teleportation rounds
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <algorithm>
+#include <numeric>
+#include "packing.h"
+
+// ----------------------------------------------------------------------
+vector<int> RemoteGatePacker::order(const Architecture& architecture,
+				    const vector<vector<int> >& demands,
+				    const vector<int>& criticality) const
+{
+  if (architecture.packing_policy == PACK_MATCHING)
+    return matching(demands, architecture.core_ltm_ports);
+  else if (architecture.packing_policy == PACK_CRITICAL_FIRST)
+    return criticalFirst(criticality);
+
+  vector<int> perm(demands.size());
+  iota(perm.begin(), perm.end(), 0);
+
+  return perm;
+}
+
+// ----------------------------------------------------------------------
+bool RemoteGatePacker::fits(const vector<int>& demand, const vector<int>& free_ports) const
+{
+  vector<int> tmp = free_ports;
+  for (int c : demand)
+    if (--tmp[c] < 0)
+      return false;
+
+  return true;
+}
+
+// ----------------------------------------------------------------------
+void RemoteGatePacker::take(const vector<int>& demand, vector<int>& free_ports) const
+{
+  for (int c : demand)
+    free_ports[c]--;
+}
+
+// ----------------------------------------------------------------------
+void RemoteGatePacker::release(const vector<int>& demand, vector<int>& free_ports) const
+{
+  for (int c : demand)
+    free_ports[c]++;
+}
+
+// ----------------------------------------------------------------------
+vector<int> RemoteGatePacker::matching(const vector<vector<int> >& demands,
+				       const vector<int>& ports) const
+{
+  int ngates = demands.size();
+  int ncores = ports.size();
+
+  // Contention of a gate: overall demand of the cores it uses
+  vector<int> core_demand(ncores, 0);
+  for (const auto& demand : demands)
+    for (int c : demand)
+      core_demand[c]++;
+
+  vector<int> bottleneck(ngates, 0);
+  for (int g = 0; g < ngates; g++)
+    for (int c : demands[g])
+      bottleneck[g] = max(bottleneck[g], core_demand[c]);
+
+  vector<int> candidates(ngates);
+  iota(candidates.begin(), candidates.end(), 0);
+  stable_sort(candidates.begin(), candidates.end(),
+	      [&bottleneck](const int a, const int b) { return bottleneck[a] > bottleneck[b]; });
+
+  vector<int> free_ports = ports;
+  vector<bool> packed(ngates, false);
+  for (int g : candidates)
+    if (fits(demands[g], free_ports))
+      {
+	take(demands[g], free_ports);
+	packed[g] = true;
+      }
+
+  // Augmentations: a packed gate is replaced by two postponed
+  // ones. Each augmentation packs one more gate, thus the loop ends.
+  bool improved = true;
+  while (improved)
+    {
+      improved = false;
+      for (int u : candidates)
+	{
+	  if (packed[u])
+	    continue;
+
+	  for (int v : candidates)
+	    {
+	      if (!packed[v])
+		continue;
+
+	      release(demands[v], free_ports);
+	      if (!fits(demands[u], free_ports))
+		{
+		  take(demands[v], free_ports);
+		  continue;
+		}
+
+	      take(demands[u], free_ports);
+	      int w = -1;
+	      for (int x : candidates)
+		if (!packed[x] && x != u && x != v && fits(demands[x], free_ports))
+		  {
+		    w = x;
+		    break;
+		  }
+
+	      if (w == -1)
+		{
+		  release(demands[u], free_ports);
+		  take(demands[v], free_ports);
+		  continue;
+		}
+
+	      take(demands[w], free_ports);
+	      packed[v] = false;
+	      packed[u] = packed[w] = true;
+	      improved = true;
+	      break;
+	    }
+	}
+    }
+
+  // Packed gates first, both groups in the order of the slice
+  vector<int> perm;
+  for (int g = 0; g < ngates; g++)
+    if (packed[g])
+      perm.push_back(g);
+  for (int g = 0; g < ngates; g++)
+    if (!packed[g])
+      perm.push_back(g);
+
+  return perm;
+}
+
+// ----------------------------------------------------------------------
+vector<int> RemoteGatePacker::criticalFirst(const vector<int>& criticality) const
+{
+  vector<int> perm(criticality.size());
+  iota(perm.begin(), perm.end(), 0);
+  stable_sort(perm.begin(), perm.end(),
+	      [&criticality](const int a, const int b) { return criticality[a] > criticality[b]; });
+
+  return perm;
+}
@@ -0,0 +1,50 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: packing.h
+// Description: Declaration of the policies packing remote gates into
+//              teleportation rounds
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __PACKING_H__
+#define __PACKING_H__
+
+#include <vector>
+#include "architecture.h"
+
+using namespace std;
+
+// The remote gates of a slice are executed in rounds. In each round
+// the gates are visited in order and a gate is packed if the LTM
+// ports it needs are still free, otherwise it is postponed to the
+// next round. The packer decides the order of the visit according to
+// architecture.packing_policy:
+// - PACK_GREEDY: order of the slice;
+// - PACK_MATCHING: the gates of a maximal set fitting the ports of
+//   the cores come first. The set is built by visiting the gates from
+//   the most to the least contended ones and is then improved by
+//   replacing one packed gate with two postponed ones while possible;
+// - PACK_CRITICAL_FIRST: gates with the largest remaining circuit
+//   depth come first.
+struct RemoteGatePacker
+{
+  // Returns the permutation of the gates to visit. demands[i] lists
+  // the cores whose ports are used by the i-th gate (a core is listed
+  // once per port) and criticality[i] is its remaining depth.
+  vector<int> order(const Architecture& architecture,
+		    const vector<vector<int> >& demands,
+		    const vector<int>& criticality) const;
+
+  // ports[c] is the number of LTM ports of core c
+  vector<int> matching(const vector<vector<int> >& demands,
+		       const vector<int>& ports) const;
+
+  vector<int> criticalFirst(const vector<int>& criticality) const;
+
+  bool fits(const vector<int>& demand, const vector<int>& free_ports) const;
+  void take(const vector<int>& demand, vector<int>& free_ports) const;
+  void release(const vector<int>& demand, vector<int>& free_ports) const;
+};
+
+#endif
@@ -38,8 +38,13 @@ void Parameters::display() const
   displayGateDelays();
   cout << IND << "epr_delay: " << epr_delay << " # sec" << endl
        << IND << "dist_delay: " << dist_delay << " # sec" << endl
+       << IND << "qlink_epr_rate: " << noc.qlink_epr_rate << " # pairs/sec" << endl
+       << IND << "qlink_hop_delay: " << noc.qlink_hop_delay << " # sec" << endl
+       << IND << "shuttle_segment_time: " << noc.shuttle_segment_time << " # sec" << endl
+       << IND << "shuttle_junction_time: " << noc.shuttle_junction_time << " # sec" << endl
        << IND << "pre_delay: " << pre_delay << " # sec" << endl
        << IND << "post_delay: " << post_delay << " # sec" << endl
+       << IND << "swap_delay: " << swap_delay << " # sec" << endl
        << IND << "memory_mandwidth: " << memory_bandwidth << " # bps" << endl
        << IND << "bits_instruction: " << bits_instruction << " # bits" << endl
        << IND << "decode_time_per_instruction: " << decode_time_per_instruction << " # sec" << endl
@@ -56,9 +61,16 @@ bool Parameters::readFromFile(const string& file_name)
   result &= getOrFail<double>(config, "dist_delay", file_name, dist_delay);
   result &= getOrFail<double>(config, "pre_delay", file_name, pre_delay);
   result &= getOrFail<double>(config, "post_delay", file_name, post_delay);
+  result &= getOrDefault<double>(config, "swap_delay", file_name, swap_delay, 390e-9);
   result &= getOrFail<double>(config, "noc_clock_time", file_name, noc.clock_time);
   result &= getOrFail<double>(config, "wbit_rate", file_name, noc.wbit_rate);
   result &= getOrFail<double>(config, "token_pass_time", file_name, noc.token_pass_time);
+  result &= getOrDefault<double>(config, "qlink_epr_rate", file_name, noc.qlink_epr_rate, 1e6);
+  result &= getOrDefault<double>(config, "qlink_hop_delay", file_name, noc.qlink_hop_delay, 0.01e-9);
+  result &= getOrDefault<double>(config, "shuttle_segment_time", file_name,
+				 noc.shuttle_segment_time, 20e-6);
+  result &= getOrDefault<double>(config, "shuttle_junction_time", file_name,
+				 noc.shuttle_junction_time, 100e-6);
   result &= getOrFail<double>(config, "memory_bandwidth", file_name, memory_bandwidth);
   result &= getOrFail<int>(config, "bits_instruction", file_name, bits_instruction);
   result &= getOrFail<double>(config, "decode_time_per_instruction", file_name, decode_time_per_instruction);
@@ -95,6 +107,11 @@ void Parameters::updatePostDelay(const double nv)
   post_delay = nv;
 }
 
+void Parameters::updateSwapDelay(const double nv)
+{
+  swap_delay = nv;
+}
+
 void Parameters::updateNoCClockTime(const double nv)
 {
   noc.clock_time = nv;
@@ -110,6 +127,26 @@ void Parameters::updateTokenPassTime(const double nv)
   noc.token_pass_time = nv;
 }
 
+void Parameters::updateQLinkEPRRate(const double nv)
+{
+  noc.qlink_epr_rate = nv;
+}
+
+void Parameters::updateQLinkHopDelay(const double nv)
+{
+  noc.qlink_hop_delay = nv;
+}
+
+void Parameters::updateShuttleSegmentTime(const double nv)
+{
+  noc.shuttle_segment_time = nv;
+}
+
+void Parameters::updateShuttleJunctionTime(const double nv)
+{
+  noc.shuttle_junction_time = nv;
+}
+
 void Parameters::updateMemoryBandwidth(const double nv)
 {
   memory_bandwidth = nv;
@@ -154,4 +191,10 @@ void Parameters::scaleQuantumRelatedParameters()
   dist_delay *= qscale_factor;
   pre_delay  *= qscale_factor;
   post_delay *= qscale_factor;
+  swap_delay *= qscale_factor;
+
+  noc.qlink_epr_rate  /= qscale_factor;
+  noc.qlink_hop_delay *= qscale_factor;
+  noc.shuttle_segment_time  *= qscale_factor;
+  noc.shuttle_junction_time *= qscale_factor;
 }
@@ -22,6 +22,7 @@ struct Parameters
   double   dist_delay;
   double   pre_delay;
   double   post_delay;
+  double   swap_delay; // entanglement swapping at an intermediate core (TP_TYPE_SWAP)
   double   memory_bandwidth; // bits/sec
   int      bits_instruction; // number of bits used for encoding an instruction
   double   decode_time_per_instruction;
@@ -48,9 +49,14 @@ struct Parameters
   void updateDistDelay(const double nv);
   void updatePreDelay(const double nv);
   void updatePostDelay(const double nv);
+  void updateSwapDelay(const double nv);
   void updateNoCClockTime(const double nv);
   void updateWBitRate(const double nv);
   void updateTokenPassTime(const double nv);
+  void updateQLinkEPRRate(const double nv);
+  void updateQLinkHopDelay(const double nv);
+  void updateShuttleSegmentTime(const double nv);
+  void updateShuttleJunctionTime(const double nv);
   void updateMemoryBandwidth(const double nv);
   void updateBitsInstruction(const int nv);
   void updateDecodeTime(const double nv);
@@ -0,0 +1,455 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: partitioning.cpp
+// Description: Implementation of the qubit interaction graph and of the
+//              multilevel graph partitioner used for the initial mapping
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <queue>
+#include <tuple>
+#include "utils.h"
+#include "partitioning.h"
+
+// Coarsening stops when the graph has less than COARSEN_TO_FACTOR
+// vertices per partition or when a level shrinks the graph by less
+// than COARSEN_MIN_REDUCTION
+#define COARSEN_TO_FACTOR     8
+#define COARSEN_MIN_REDUCTION 0.95
+
+#define FM_MAX_PASSES 8
+#define FM_EPS        1e-9
+
+// ----------------------------------------------------------------------
+void InteractionGraph::build(const Circuit& circuit, const double decay)
+{
+  nvertices = circuit.number_of_qubits;
+  vweight.assign(nvertices, 1);
+  adj.assign(nvertices, vector<pair<int,double> >());
+
+  // Collect the edges <u, v, w> with u < v and merge the duplicates
+  // after sorting. This keeps the construction O(E log E).
+  vector<tuple<int,int,double> > edges;
+  int slice = 0;
+  for (const auto& pg : circuit.circuit)
+    {
+      double w = 1.0 / (1.0 + decay * slice);
+      for (const auto& gate : pg)
+	for (auto qi = gate.second.begin(); qi != gate.second.end(); ++qi)
+	  for (auto qj = next(qi); qj != gate.second.end(); ++qj)
+	    if (*qi != *qj)
+	      edges.push_back(make_tuple(min(*qi, *qj), max(*qi, *qj), w));
+      slice++;
+    }
+
+  sort(edges.begin(), edges.end());
+
+  for (size_t i = 0; i < edges.size(); )
+    {
+      int u = get<0>(edges[i]);
+      int v = get<1>(edges[i]);
+      double w = 0.0;
+      for (; i < edges.size() && get<0>(edges[i]) == u && get<1>(edges[i]) == v; i++)
+	w += get<2>(edges[i]);
+
+      adj[u].push_back(make_pair(v, w));
+      adj[v].push_back(make_pair(u, w));
+    }
+}
+
+// ----------------------------------------------------------------------
+double InteractionGraph::edgeCut(const vector<int>& part) const
+{
+  double cut = 0.0;
+
+  for (int v = 0; v < nvertices; v++)
+    for (const auto& e : adj[v])
+      if (v < e.first && part[v] != part[e.first])
+	cut += e.second;
+
+  return cut;
+}
+
+// ----------------------------------------------------------------------
+int Partitioner::partDistance(const int a, const int b) const
+{
+  if (a == b)
+    return 0;
+
+  return (noc == nullptr) ? 1 : noc->getHopDistance(a, b);
+}
+
+// ----------------------------------------------------------------------
+InteractionGraph Partitioner::coarsen(const InteractionGraph& graph, vector<int>& cmap)
+{
+  int n = graph.nvertices;
+  int max_vweight = max(1, max_part_weight / 3);
+
+  vector<int> order(n);
+  for (int v = 0; v < n; v++)
+    order[v] = v;
+  shuffle(order.begin(), order.end(), gen);
+
+  // Heavy-edge matching
+  vector<int> match(n, -1);
+  for (int v : order)
+    {
+      if (match[v] != -1)
+	continue;
+
+      int best = -1;
+      double best_w = 0.0;
+      for (const auto& e : graph.adj[v])
+	{
+	  int u = e.first;
+	  if (match[u] == -1 && u != v &&
+	      graph.vweight[v] + graph.vweight[u] <= max_vweight &&
+	      e.second > best_w)
+	    {
+	      best = u;
+	      best_w = e.second;
+	    }
+	}
+
+      if (best == -1)
+	match[v] = v;
+      else
+	{
+	  match[v] = best;
+	  match[best] = v;
+	}
+    }
+
+  // Number the coarse vertices
+  cmap.assign(n, -1);
+  int nc = 0;
+  for (int v = 0; v < n; v++)
+    if (cmap[v] == -1)
+      {
+	cmap[v] = nc;
+	cmap[match[v]] = nc;
+	nc++;
+      }
+
+  InteractionGraph coarse;
+  coarse.nvertices = nc;
+  coarse.vweight.assign(nc, 0);
+  coarse.adj.assign(nc, vector<pair<int,double> >());
+
+  for (int v = 0; v < n; v++)
+    coarse.vweight[cmap[v]] += graph.vweight[v];
+
+  // Merge the adjacency lists of the collapsed vertices. pos[c] is
+  // the position of coarse neighbour c in the list being built.
+  vector<int> pos(nc, -1);
+  for (int v = 0; v < n; v++)
+    {
+      int cv = cmap[v];
+      if (match[v] < v && match[v] != v)
+	continue; // already merged with its mate
+
+      vector<pair<int,double> >& cadj = coarse.adj[cv];
+      int members[2] = {v, match[v]};
+      int nmembers = (match[v] == v) ? 1 : 2;
+      for (int m = 0; m < nmembers; m++)
+	for (const auto& e : graph.adj[members[m]])
+	  {
+	    int cu = cmap[e.first];
+	    if (cu == cv)
+	      continue;
+
+	    if (pos[cu] == -1)
+	      {
+		pos[cu] = cadj.size();
+		cadj.push_back(make_pair(cu, e.second));
+	      }
+	    else
+	      cadj[pos[cu]].second += e.second;
+	  }
+
+      for (const auto& e : cadj)
+	pos[e.first] = -1;
+    }
+
+  return coarse;
+}
+
+// ----------------------------------------------------------------------
+bool Partitioner::bestMove(const InteractionGraph& graph, const vector<int>& part,
+			   const vector<int>& loads, const int v, const bool any_part,
+			   int& target, double& gain)
+{
+  int from = part[v];
+
+  touched.clear();
+  for (const auto& e : graph.adj[v])
+    {
+      int p = part[e.first];
+      if (p < 0)
+	continue;
+      if (conn[p] == 0.0)
+	touched.push_back(p);
+      conn[p] += e.second;
+    }
+
+  // cost of placing v in partition p
+  auto cost = [&](const int p) {
+    double c = 0.0;
+    for (int q : touched)
+      c += conn[q] * partDistance(p, q);
+    return c;
+  };
+
+  double from_cost = (from < 0) ? 0.0 : cost(from);
+  bool found = false;
+  target = -1;
+  gain = 0.0;
+
+  auto consider = [&](const int p) {
+    if (p == from || loads[p] + graph.vweight[v] > max_part_weight)
+      return;
+    double g = from_cost - cost(p);
+    if (!found || g > gain + FM_EPS ||
+	(fabs(g - gain) <= FM_EPS && loads[p] < loads[target]))
+      {
+	found = true;
+	target = p;
+	gain = g;
+      }
+  };
+
+  if (any_part)
+    for (int p = 0; p < nparts; p++)
+      consider(p);
+  else
+    for (int p : touched)
+      consider(p);
+
+  for (int p : touched)
+    conn[p] = 0.0;
+
+  return found;
+}
+
+// ----------------------------------------------------------------------
+vector<int> Partitioner::initialPartition(const InteractionGraph& graph)
+{
+  int n = graph.nvertices;
+
+  // Heaviest vertices first, then the most connected ones
+  vector<double> degree(n, 0.0);
+  for (int v = 0; v < n; v++)
+    for (const auto& e : graph.adj[v])
+      degree[v] += e.second;
+
+  vector<int> order(n);
+  for (int v = 0; v < n; v++)
+    order[v] = v;
+  stable_sort(order.begin(), order.end(), [&](const int a, const int b) {
+      if (graph.vweight[a] != graph.vweight[b])
+	return graph.vweight[a] > graph.vweight[b];
+      return degree[a] > degree[b];
+    });
+
+  vector<int> part(n, -1);
+  vector<int> loads(nparts, 0);
+  for (int v : order)
+    {
+      int target;
+      double gain;
+      if (!bestMove(graph, part, loads, v, true, target, gain))
+	{
+	  // No partition can accept v: place it in the lightest one,
+	  // balance() will fix the overload later
+	  target = min_element(loads.begin(), loads.end()) - loads.begin();
+	}
+
+      part[v] = target;
+      loads[target] += graph.vweight[v];
+    }
+
+  return part;
+}
+
+// ----------------------------------------------------------------------
+void Partitioner::balance(const InteractionGraph& graph, vector<int>& part, vector<int>& loads)
+{
+  int n = graph.nvertices;
+
+  for (int p = 0; p < nparts; p++)
+    {
+      if (loads[p] <= max_part_weight)
+	continue;
+
+      // Rank the vertices of p by the gain of their best feasible move
+      vector<pair<double,int> > candidates;
+      for (int v = 0; v < n; v++)
+	if (part[v] == p)
+	  {
+	    int target;
+	    double gain;
+	    if (bestMove(graph, part, loads, v, true, target, gain))
+	      candidates.push_back(make_pair(gain, v));
+	  }
+      sort(candidates.begin(), candidates.end(),
+	   [](const pair<double,int>& a, const pair<double,int>& b) {
+	     return a.first > b.first;
+	   });
+
+      for (const auto& c : candidates)
+	{
+	  if (loads[p] <= max_part_weight)
+	    break;
+
+	  int v = c.second;
+	  int target;
+	  double gain;
+	  if (bestMove(graph, part, loads, v, true, target, gain))
+	    {
+	      loads[p] -= graph.vweight[v];
+	      loads[target] += graph.vweight[v];
+	      part[v] = target;
+	    }
+	}
+    }
+}
+
+// ----------------------------------------------------------------------
+void Partitioner::refine(const InteractionGraph& graph, vector<int>& part, vector<int>& loads)
+{
+  int n = graph.nvertices;
+  int stall_limit = 50 + n / 100;
+
+  for (int pass = 0; pass < FM_MAX_PASSES; pass++)
+    {
+      vector<bool> locked(n, false);
+      priority_queue<tuple<double,int,int> > heap; // <gain, vertex, target>
+      vector<pair<int,int> > moves; // <vertex, source partition>
+
+      for (int v = 0; v < n; v++)
+	{
+	  int target;
+	  double gain;
+	  if (bestMove(graph, part, loads, v, false, target, gain))
+	    heap.push(make_tuple(gain, v, target));
+	}
+
+      double cum_gain = 0.0, best_gain = 0.0;
+      size_t best_nmoves = 0;
+      while (!heap.empty())
+	{
+	  int v = get<1>(heap.top());
+	  double gain = get<0>(heap.top());
+	  heap.pop();
+
+	  if (locked[v])
+	    continue;
+
+	  // The gain might be stale because of the moves of the
+	  // neighbours or the target might be full
+	  int target;
+	  double cur_gain;
+	  if (!bestMove(graph, part, loads, v, false, target, cur_gain))
+	    continue;
+	  if (fabs(cur_gain - gain) > FM_EPS)
+	    {
+	      heap.push(make_tuple(cur_gain, v, target));
+	      continue;
+	    }
+
+	  moves.push_back(make_pair(v, part[v]));
+	  loads[part[v]] -= graph.vweight[v];
+	  loads[target] += graph.vweight[v];
+	  part[v] = target;
+	  locked[v] = true;
+	  cum_gain += cur_gain;
+
+	  if (cum_gain > best_gain + FM_EPS)
+	    {
+	      best_gain = cum_gain;
+	      best_nmoves = moves.size();
+	    }
+	  else if ((int)(moves.size() - best_nmoves) > stall_limit)
+	    break;
+
+	  for (const auto& e : graph.adj[v])
+	    {
+	      int u = e.first;
+	      double u_gain;
+	      if (!locked[u] && bestMove(graph, part, loads, u, false, target, u_gain))
+		heap.push(make_tuple(u_gain, u, target));
+	    }
+	}
+
+      // Roll back the moves done after the best prefix
+      while (moves.size() > best_nmoves)
+	{
+	  int v = moves.back().first;
+	  int src = moves.back().second;
+	  loads[part[v]] -= graph.vweight[v];
+	  loads[src] += graph.vweight[v];
+	  part[v] = src;
+	  moves.pop_back();
+	}
+
+      if (best_gain <= FM_EPS)
+	break;
+    }
+}
+
+// ----------------------------------------------------------------------
+vector<int> Partitioner::partition(const InteractionGraph& graph)
+{
+  assert(nparts > 0);
+  conn.assign(nparts, 0.0);
+  touched.clear();
+
+  // Coarsening phase
+  list<InteractionGraph> graphs;
+  list<vector<int> > cmaps;
+  const InteractionGraph* current = &graph;
+  while (current->nvertices > COARSEN_TO_FACTOR * nparts)
+    {
+      vector<int> cmap;
+      InteractionGraph coarse = coarsen(*current, cmap);
+      if (coarse.nvertices > COARSEN_MIN_REDUCTION * current->nvertices)
+	break;
+
+      graphs.push_back(coarse);
+      cmaps.push_back(cmap);
+      current = &graphs.back();
+    }
+
+  // Initial partitioning of the coarsest graph
+  vector<int> part = initialPartition(*current);
+  vector<int> loads(nparts, 0);
+  for (int v = 0; v < current->nvertices; v++)
+    loads[part[v]] += current->vweight[v];
+  balance(*current, part, loads);
+  refine(*current, part, loads);
+
+  // Uncoarsening phase: project the partition on the finer graph and
+  // refine it
+  while (!graphs.empty())
+    {
+      graphs.pop_back();
+      const InteractionGraph& finer = graphs.empty() ? graph : graphs.back();
+      const vector<int>& cmap = cmaps.back();
+
+      vector<int> fine_part(finer.nvertices);
+      for (int v = 0; v < finer.nvertices; v++)
+	fine_part[v] = part[cmap[v]];
+      part.swap(fine_part);
+      cmaps.pop_back();
+
+      balance(finer, part, loads);
+      refine(finer, part, loads);
+    }
+
+  return part;
+}
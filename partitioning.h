@@ -0,0 +1,91 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: partitioning.h
+// Description: Declaration of the qubit interaction graph and of the
+//              multilevel graph partitioner used for the initial mapping
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __PARTITIONING_H__
+#define __PARTITIONING_H__
+
+#include <vector>
+#include <random>
+#include "circuit.h"
+#include "noc.h"
+
+using namespace std;
+
+// Weighted qubit interaction graph. In the finest graph vertex v is
+// qubit v. Coarser graphs are obtained by collapsing matched vertices
+// and vweight keeps track of how many qubits a vertex represents.
+struct InteractionGraph
+{
+  int nvertices;
+  vector<int> vweight; // number of qubits represented by each vertex
+  vector<vector<pair<int,double> > > adj; // adj[v] = list of <neighbour, edge weight>
+
+  InteractionGraph() : nvertices(0) {}
+
+  // Builds the graph from the circuit. Each gate in slice s adds
+  // 1/(1 + decay*s) to the weight of the edge between every pair of
+  // its qubits, so that early interactions count more than late ones
+  // (decay = 0 means no decay).
+  void build(const Circuit& circuit, const double decay);
+
+  // Returns the sum of the weights of the edges whose endpoints are
+  // assigned to different partitions
+  double edgeCut(const vector<int>& part) const;
+};
+
+// Multilevel k-way partitioner: the graph is coarsened by heavy-edge
+// matching, the coarsest graph is partitioned by greedy graph
+// growing, and the partition is projected back level by level and
+// refined with a Fiduccia-Mattheyses (FM) pass at each level. The
+// weight of each partition never exceeds max_part_weight.
+struct Partitioner
+{
+  int        nparts;
+  int        max_part_weight;
+  const NoC* noc; // if not null, cut edges are weighted by the hop distance between partitions
+  mt19937    gen;
+
+  Partitioner(const int _nparts, const int _max_part_weight,
+	      const NoC* _noc, const unsigned seed)
+    : nparts(_nparts), max_part_weight(_max_part_weight), noc(_noc), gen(seed) {}
+
+  // Returns part[v] in [0, nparts) for each vertex of graph
+  vector<int> partition(const InteractionGraph& graph);
+
+  // Collapses pairs of vertices connected by heavy edges. cmap[v]
+  // gives the coarse vertex v has been collapsed into
+  InteractionGraph coarsen(const InteractionGraph& graph, vector<int>& cmap);
+
+  vector<int> initialPartition(const InteractionGraph& graph);
+
+  // Moves vertices out of the partitions whose weight exceeds
+  // max_part_weight
+  void balance(const InteractionGraph& graph, vector<int>& part, vector<int>& loads);
+
+  // FM refinement with hill climbing: moves with negative gain are
+  // allowed and the best prefix of the moves is kept
+  void refine(const InteractionGraph& graph, vector<int>& part, vector<int>& loads);
+
+  // Cost of a cut edge between partitions a and b
+  int partDistance(const int a, const int b) const;
+
+  // Computes the best move of vertex v toward a partition that can
+  // accept it. If any_part is true every partition is a candidate,
+  // otherwise only the partitions of the neighbours of v are
+  // considered. Returns false if there are no feasible moves
+  bool bestMove(const InteractionGraph& graph, const vector<int>& part,
+		const vector<int>& loads, const int v, const bool any_part,
+		int& target, double& gain);
+
+  // Scratch buffers used by bestMove
+  vector<double> conn;
+  vector<int>    touched;
+};
+
+#endif
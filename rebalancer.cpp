@@ -0,0 +1,119 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: rebalancer.cpp
+// Description: Implementation of the background rebalancer of the core loads
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <limits>
+#include <set>
+#include <vector>
+#include "rebalancer.h"
+
+// ----------------------------------------------------------------------
+void Rebalancer::reset()
+{
+  pending.clear();
+  slices = 0;
+}
+
+// ----------------------------------------------------------------------
+bool Rebalancer::isEnabled(const Architecture& architecture) const
+{
+  return (architecture.rebalance_interval > 0 || architecture.rebalance_threshold > 0.0);
+}
+
+// ----------------------------------------------------------------------
+double Rebalancer::imbalance(const Architecture& architecture, const Cores& cores) const
+{
+  // occupancy of the cores, which may have different capacities
+  double min_load = numeric_limits<double>::max();
+  double max_load = 0.0;
+
+  for (int c = 0; c < cores.getNumCores(); c++)
+    {
+      double load = (double)cores.cores[c].size() / architecture.getCoreCapacity(c);
+      min_load = min(min_load, load);
+      max_load = max(max_load, load);
+    }
+
+  return max_load - min_load;
+}
+
+// ----------------------------------------------------------------------
+bool Rebalancer::isTriggered(const Architecture& architecture, const Cores& cores)
+{
+  slices++;
+
+  // A new batch is planned only when the previous one is completed
+  if (!pending.empty())
+    return false;
+
+  if (architecture.rebalance_interval > 0 && slices % architecture.rebalance_interval == 0)
+    return true;
+
+  return (architecture.rebalance_threshold > 0.0 &&
+	  imbalance(architecture, cores) >= architecture.rebalance_threshold);
+}
+
+// ----------------------------------------------------------------------
+void Rebalancer::plan(const Architecture& architecture, const Cores& cores,
+		      const map<int,long>& last_use)
+{
+  int ncores = cores.getNumCores();
+  vector<int> load(ncores);
+  for (int c = 0; c < ncores; c++)
+    load[c] = cores.cores[c].size();
+
+  set<int> planned;
+  while (true)
+    {
+      // Pair of cores with the largest load difference. With mesh
+      // teleportation qubits can only be migrated to neighbor cores.
+      int src = -1, dst = -1;
+      for (int a = 0; a < ncores; a++)
+	for (int b = 0; b < ncores; b++)
+	  {
+	    if (a == b || load[b] >= architecture.getCoreCapacity(b) ||
+		(architecture.teleportation_type == TP_TYPE_MESH &&
+		 !architecture.noc.areNeighbors(a, b)))
+	      continue;
+
+	    if (src == -1 || load[a] - load[b] > load[src] - load[dst])
+	      {
+		src = a;
+		dst = b;
+	      }
+	  }
+
+      if (src == -1 || load[src] - load[dst] <= 1)
+	break;
+
+      // Least recently used qubit of src not planned yet (ancillas
+      // are never migrated)
+      int victim = -1;
+      long oldest = numeric_limits<long>::max();
+      for (int qb : cores.cores[src])
+	{
+	  if (qb < 0 || planned.find(qb) != planned.end())
+	    continue;
+
+	  auto it = last_use.find(qb);
+	  long used = (it == last_use.end()) ? -1 : it->second;
+	  if (used < oldest)
+	    {
+	      oldest = used;
+	      victim = qb;
+	    }
+	}
+
+      if (victim == -1)
+	break;
+
+      pending.push_back({victim, src, dst});
+      planned.insert(victim);
+      load[src]--;
+      load[dst]++;
+    }
+}
@@ -0,0 +1,59 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: rebalancer.h
+// Description: Declaration of the background rebalancer of the core loads
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __REBALANCER_H__
+#define __REBALANCER_H__
+
+#include <list>
+#include <map>
+#include "architecture.h"
+#include "core.h"
+
+using namespace std;
+
+// Planned migration of a qubit
+struct Migration
+{
+  int qubit;
+  int src_core;
+  int dst_core;
+};
+
+// The rebalancer is triggered every rebalance_interval slices or when
+// the imbalance of the core occupancies (fractions of the core
+// capacities), max - min, reaches rebalance_threshold. When
+// triggered, it plans a batch of migrations from the most to the
+// least loaded cores (neighbor cores with TP_TYPE_MESH) that levels
+// the loads. The least recently used qubits are migrated. The
+// migrations are then executed in background after each slice, in
+// the LTM ports left idle by its last round (see
+// Simulation::rebalance).
+struct Rebalancer
+{
+  list<Migration> pending; // planned migrations not executed yet
+  long            slices;  // slices simulated so far
+
+  Rebalancer() : slices(0) {}
+
+  void reset();
+
+  bool isEnabled(const Architecture& architecture) const;
+
+  // Must be called once per slice. Returns true if a new batch has to
+  // be planned.
+  bool isTriggered(const Architecture& architecture, const Cores& cores);
+
+  // Plans the migrations needed to level the load of the cores.
+  // last_use maps the qubits to the step of their last use.
+  void plan(const Architecture& architecture, const Cores& cores,
+	    const map<int,long>& last_use);
+
+  double imbalance(const Architecture& architecture, const Cores& cores) const;
+};
+
+#endif
@@ -10,6 +10,7 @@
 #include <sstream>
 #include <cassert>
 #include <cmath>
+#include <algorithm>
 #include "utils.h"
 #include "simulation.h"
 #include "gate.h"
@@ -84,16 +85,18 @@ double Simulation::getMaxGateLatency(const ParallelGates& lgates,
 
 // ----------------------------------------------------------------------
 Statistics Simulation::localExecution(const ParallelGates& lgates,
-				      const Parameters& params)
+				      const Architecture& architecture,
+				      const Parameters& params,
+				      const Mapping& mapping, const Cores& cores)
 {
   Statistics stats;
 
   if (!lgates.empty())
     {
       // lgates are executed in parallel; the latency is determined by
-      // the slowest gate
-      stats.computation_time = getMaxGateLatency(lgates, params.gate_delays);
-      // TODO: add swap contribution like in the remote execution
+      // the slowest gate, including its SWAP chain
+      stats.computation_time = getLocalGatesLatency(lgates, architecture, params,
+						    mapping, cores, stats);
       stats.executed_gates = lgates.size();
     }
 
@@ -102,6 +105,62 @@ Statistics Simulation::localExecution(const ParallelGates& lgates,
   return stats;
 }
 
+// ----------------------------------------------------------------------
+const map<string,double>& Simulation::getGateDelays(const Architecture& architecture,
+						     const Parameters& params, const int core_id)
+{
+  if (architecture.core_gate_delays.empty())
+    return params.gate_delays;
+
+  return architecture.core_gate_delays[core_id];
+}
+
+// ----------------------------------------------------------------------
+double Simulation::getLocalGatesLatency(const ParallelGates& gates,
+					const Architecture& architecture,
+					const Parameters& params,
+					const Mapping& mapping, const Cores& cores,
+					Statistics& stats)
+{
+  double latency = -1;
+  for (const auto& gate : gates)
+    latency = max(latency, getMaxGateLatency({gate}, getGateDelays(architecture, params,
+								    getDispatchCore(gate, mapping))));
+
+  if (!router.isEnabled())
+    return latency;
+
+  double routed_latency = latency;
+  set<int> synced;
+  for (const auto& gate : gates)
+    {
+      // the two halves of a telegate are executed in different cores
+      int core_id = mapping.qubit2CoreSafe(gate.second.front());
+      bool local = true;
+      for (int qb : gate.second)
+	local &= (mapping.qubit2CoreSafe(qb) == core_id);
+      if (!local)
+	continue;
+
+      if (synced.insert(core_id).second)
+	router.sync(core_id, cores.cores[core_id]);
+
+      const map<string,double>& gate_delays = getGateDelays(architecture, params, core_id);
+      int swaps = router.route(core_id, gate);
+      double t_swap = 0.0;
+      if (swaps > 0)
+	t_swap = getMaxGateLatency({Gate("SWAP", {})}, gate_delays);
+      swaps_per_core[core_id] += swaps;
+      stats.local_swaps += swaps;
+      routed_latency = max(routed_latency, swaps * t_swap +
+			   getMaxGateLatency({gate}, gate_delays));
+    }
+
+  stats.local_swap_time += routed_latency - latency;
+
+  return routed_latency;
+}
+
 // ----------------------------------------------------------------------
 // Choose the target core based on the number of allocated
 // qubits. Select the core with the fewest allocated qubits.  This is
@@ -109,18 +168,28 @@ Statistics Simulation::localExecution(const ParallelGates& lgates,
 // otherwise it is assumed that the first qubit is the source and the
 // second is the destination.
 int Simulation::selectDestinationCore(const Architecture& architecture,
-				      const Gate& gate, const Mapping& mapping, const Cores& cores)
+				      const Gate& gate, const Mapping& mapping, const Cores& cores,
+				      const vector<int>* available_ltm_ports)
 {
   int selected_core;
   
-  if (architecture.teleportation_type == TP_TYPE_MESH ||
-      architecture.dst_selection_mode == DST_SEL_LOAD_INDEPENDENT)
+  if ((architecture.teleportation_type == TP_TYPE_MESH ||
+       architecture.dst_selection_mode == DST_SEL_LOAD_INDEPENDENT) &&
+      gate.second.size() > 2)
+    selected_core = selectGatheringCore(architecture, gate, mapping, cores);
+  else if (architecture.teleportation_type == TP_TYPE_MESH ||
+	   architecture.dst_selection_mode == DST_SEL_LOAD_INDEPENDENT)
     {
       assert(gate.second.size() == 2);
       auto it = gate.second.begin(); 
       advance(it, 1);    
       selected_core = mapping.qubit2CoreSafe(*it);
     }
+  else if (architecture.dst_selection_mode == DST_SEL_LOOKAHEAD)
+    selected_core = selectDestinationCoreLookahead(architecture, gate, mapping, cores);
+  else if (architecture.dst_selection_mode == DST_SEL_COST)
+    selected_core = selectDestinationCoreCost(architecture, gate, mapping, cores,
+					      available_ltm_ports);
   else
     {
       int min_qb = numeric_limits<int>::max();
@@ -142,6 +211,280 @@ int Simulation::selectDestinationCore(const Architecture& architecture,
   return selected_core;
 }
 
+// ----------------------------------------------------------------------
+// Choose the target core among the cores hosting the qubits of the
+// gate based on a score that takes into account:
+// - the future partners of the qubits of the gate within the next
+//   lookahead_slices slices that are mapped on the core (discounted
+//   by their distance in time);
+// - the number of teleportations needed now;
+// - the occupancy of the core;
+// - the hops traveled by the teleported qubits.
+// Cores that cannot accommodate the incoming qubits while keeping a
+// free slot are discarded: the free slot guarantees that the least
+// loaded core of a later gate can always receive one qubit. If none
+// of the cores can accommodate the qubits, the least loaded core of
+// the architecture that can receive all of them (capacity and LTM
+// ports) is selected, or the least loaded core of the gate as a last
+// resort.
+int Simulation::selectDestinationCoreLookahead(const Architecture& architecture,
+					       const Gate& gate, const Mapping& mapping,
+					       const Cores& cores)
+{
+  int selected_core = -1, min_qb_core = -1;
+  double best_score = 0.0;
+  int min_qb = numeric_limits<int>::max();
+
+  for (const auto& cqb : gate.second)
+    {
+      int core_id = mapping.qubit2CoreSafe(cqb);
+      int core_size = cores.cores[core_id].size();
+
+      if (core_size < min_qb)
+	{
+	  min_qb = core_size;
+	  min_qb_core = core_id;
+	}
+
+      int incoming = 0, hops = 0;
+      double aff = 0.0;
+      for (const auto& qb : gate.second)
+	{
+	  int src_core = mapping.qubit2CoreSafe(qb);
+	  if (src_core != core_id)
+	    {
+	      incoming++;
+	      hops += architecture.noc.getHopDistance(src_core, core_id);
+	    }
+	  aff += lookahead.affinity(qb, core_id, current_slice,
+				    architecture.lookahead_slices,
+				    architecture.lookahead_discount,
+				    mapping, gate.second);
+	}
+
+      if (core_size + incoming >= architecture.getCoreCapacity(core_id))
+	continue;
+
+      double score = aff - incoming
+	- architecture.lookahead_load_weight * core_size / architecture.getCoreCapacity(core_id)
+	- architecture.lookahead_hop_weight * hops;
+
+      if (selected_core == -1 || score > best_score)
+	{
+	  best_score = score;
+	  selected_core = core_id;
+	}
+    }
+
+  int nqubits = gate.second.size();
+  if (selected_core == -1)
+    {
+      int min_size = numeric_limits<int>::max();
+      for (int core_id = 0; core_id < cores.getNumCores(); core_id++)
+	{
+	  int core_size = cores.cores[core_id].size();
+	  if (nqubits <= architecture.getCoreLTMPorts(core_id) &&
+	      core_size + nqubits < architecture.getCoreCapacity(core_id) && core_size < min_size)
+	    {
+	      min_size = core_size;
+	      selected_core = core_id;
+	    }
+	}
+    }
+
+  if (selected_core == -1)
+    selected_core = min_qb_core;
+
+  return selected_core;
+}
+
+// ----------------------------------------------------------------------
+// The cost of a core is the weighted sum of:
+// - the hops traveled by the teleported qubits times the link cycles
+//   of a teleportation message (classical transfer);
+// - the teleportations that exceed the LTM ports still free in the
+//   current round at the destination and at the sources (they would
+//   be postponed to another round);
+// - the occupancy of the core after the teleportations;
+// - the ancillas needed along the paths (TP_TYPE_MESH only).
+double Simulation::getDestinationCost(const Architecture& architecture,
+				      const Gate& gate, const int core_id, const Mapping& mapping,
+				      const Cores& cores, const vector<int>* available_ltm_ports)
+{
+  int volume = ceil(log2(2+architecture.total_physical_qubits));
+  int link_cycles = architecture.noc.linkTraversalCycles(volume);
+  int incoming = 0, hops = 0, ancillas = 0, port_deficit = 0;
+  map<int,int> src_ports;
+
+  for (const auto& qb : gate.second)
+    {
+      int src_core = mapping.qubit2CoreSafe(qb);
+      if (src_core == core_id)
+	continue;
+
+      int h = architecture.noc.getHopDistance(src_core, core_id);
+      incoming++;
+      hops += h;
+      if (architecture.teleportation_type == TP_TYPE_MESH)
+	ancillas += h - 1;
+
+      if (available_ltm_ports != nullptr)
+	{
+	  auto it = src_ports.insert(make_pair(src_core, (*available_ltm_ports)[src_core])).first;
+	  if (it->second > 0)
+	    it->second--;
+	  else
+	    port_deficit++;
+	}
+    }
+
+  if (available_ltm_ports != nullptr)
+    port_deficit += max(0, incoming - (*available_ltm_ports)[core_id]);
+
+  double occupancy = (double)(cores.cores[core_id].size() + incoming) /
+    architecture.getCoreCapacity(core_id);
+
+  return architecture.dst_cost_hop_weight * hops * link_cycles
+    + architecture.dst_cost_port_weight * port_deficit
+    + architecture.dst_cost_load_weight * occupancy
+    + architecture.dst_cost_ancilla_weight * ancillas;
+}
+
+// ----------------------------------------------------------------------
+int Simulation::selectGatheringCore(const Architecture& architecture, const Gate& gate,
+				    const Mapping& mapping, const Cores& cores,
+				    const map<int,int>* reserved)
+{
+  const NoC& noc = architecture.noc;
+  map<int,int> hosted; // core --> qubits of gate
+  for (int qb : gate.second)
+    hosted[mapping.qubit2CoreSafe(qb)]++;
+
+  vector<int> candidates;
+  if (architecture.teleportation_type == TP_TYPE_MESH)
+    for (int c = 0; c < architecture.number_of_cores; c++)
+      candidates.push_back(c);
+  else
+    for (const auto& h : hosted)
+      candidates.push_back(h.first);
+
+  // the best core with room and, as a fallback, the best core
+  // hosting the qubits
+  int selected_core = -1, min_hops = 0, max_hosted = 0;
+  int fallback_core = -1, fallback_hops = 0, fallback_hosted = 0;
+  for (int c : candidates)
+    {
+      int hops = 0;
+      for (const auto& h : hosted)
+	hops += h.second * noc.getHopDistance(h.first, c);
+
+      int here = hosted.count(c) ? hosted[c] : 0;
+      if (here > 0 &&
+	  (fallback_core == -1 || hops < fallback_hops ||
+	   (hops == fallback_hops && here > fallback_hosted)))
+	{
+	  fallback_core = c;
+	  fallback_hops = hops;
+	  fallback_hosted = here;
+	}
+
+      if (architecture.teleportation_type == TP_TYPE_MESH &&
+	  !hasGatheringRoom(architecture, gate, c, mapping, cores, reserved))
+	continue;
+      
+      if (selected_core == -1 || hops < min_hops || (hops == min_hops && here > max_hosted))
+	{
+	  selected_core = c;
+	  min_hops = hops;
+	  max_hosted = here;
+	}
+    }
+
+  if (selected_core == -1)
+    selected_core = fallback_core;
+
+  return selected_core;
+}
+
+// ----------------------------------------------------------------------
+bool Simulation::hasGatheringRoom(const Architecture& architecture, const Gate& gate,
+				  const int core_id, const Mapping& mapping, const Cores& cores,
+				  const map<int,int>* reserved)
+{
+  map<int,int> needed; // core --> slots
+  bool anchor = true;
+  for (int qb : gate.second)
+    {
+      int src_core = mapping.qubit2CoreSafe(qb);
+      if (src_core == core_id)
+	{
+	  anchor = false;
+	  continue;
+	}
+
+      needed[core_id]++;
+      vector<int> path = getCorePath(src_core, core_id, qb, architecture.noc);
+      for (size_t i = 1; i + 1 < path.size(); i++)
+	needed[path[i]] += 2;
+    }
+  if (anchor)
+    needed[core_id]++;
+
+  for (const auto& n : needed)
+    {
+      int slots = n.second;
+      if (reserved != nullptr && reserved->count(n.first))
+	slots += reserved->at(n.first);
+      if ((int)cores.cores[n.first].size() + slots > architecture.getCoreCapacity(n.first))
+	return false;
+    }
+
+  return true;
+}
+
+// ----------------------------------------------------------------------
+// Choose the target core of any gate (any number of qubits) among the
+// cores hosting its qubits as the one with the lowest cost (see
+// getDestinationCost). Cores that cannot accommodate the incoming
+// qubits are considered only if no other core can.
+int Simulation::selectDestinationCoreCost(const Architecture& architecture,
+					  const Gate& gate, const Mapping& mapping,
+					  const Cores& cores, const vector<int>* available_ltm_ports)
+{
+  int selected_core = -1;
+  bool selected_fits = false;
+  double min_cost = 0.0;
+
+  for (const auto& cqb : gate.second)
+    {
+      int core_id = mapping.qubit2CoreSafe(cqb);
+      if (core_id == selected_core)
+	continue;
+
+      int incoming = 0;
+      for (const auto& qb : gate.second)
+	if (mapping.qubit2CoreSafe(qb) != core_id)
+	  incoming++;
+      bool fits = ((int)cores.cores[core_id].size() + incoming <=
+		   architecture.getCoreCapacity(core_id));
+
+      double cost = getDestinationCost(architecture, gate, core_id, mapping, cores,
+				       available_ltm_ports);
+
+      if (selected_core == -1 || (fits && !selected_fits) ||
+	  (fits == selected_fits && cost < min_cost))
+	{
+	  selected_core = core_id;
+	  selected_fits = fits;
+	  min_cost = cost;
+	}
+    }
+
+  assert(selected_core != -1);
+
+  return selected_core;
+}
+
 // ----------------------------------------------------------------------
 // qubits in gate are allocated to dst_core. Both mapping and cores
 // structures are updated accordingly.
@@ -155,9 +498,10 @@ void Simulation::updateMappingAndCores(const Architecture& architecture,
 
       if (src_core != dst_core)
 	{
+	  cancelPrefetch(qb);
 	  mapping.qubit2core[qb] = dst_core;
 	  cores.cores[dst_core].insert(qb);
-	  assert((int)cores.cores[dst_core].size() < architecture.qubits_per_core);
+	  assert((int)cores.cores[dst_core].size() <= architecture.getCoreCapacity(dst_core));
 	  
 	  auto it = cores.cores[src_core].find(qb);
 	  assert(it != cores.cores[src_core].end());
@@ -166,6 +510,269 @@ void Simulation::updateMappingAndCores(const Architecture& architecture,
     }
 }
 
+// ----------------------------------------------------------------------
+void Simulation::makeRoom(const Architecture& architecture, Mapping& mapping, Cores& cores,
+			  const int core_id, const int nslots, const set<int>& protected_set)
+{
+  while (architecture.getCoreCapacity(core_id) - (int)cores.cores[core_id].size() < nslots)
+    {
+      Eviction ev;
+      if (architecture.eviction_policy == EVICT_NONE ||
+	  !eviction.selectEviction(architecture, mapping, cores, lookahead, current_slice,
+				   core_id, protected_set, ev))
+	{
+	  ostringstream oss;
+	  oss << "Core " << core_id << " is full and no qubit can be evicted";
+	  if (architecture.eviction_policy == EVICT_NONE)
+	    oss << " (eviction_policy is 0)";
+	  else if (eviction.selectTargetCore(architecture, cores, core_id) == -1)
+	    oss << " (no core has free capacity)";
+	  FATAL(oss.str());
+	}
+
+      eviction_comms.push_back(Communication(ev.src_core, ev.dst_core,
+					     ceil(log2(2+architecture.total_physical_qubits))));
+      evicted_qubits.push_back(ev.qubit);
+      cancelPrefetch(ev.qubit);
+
+      mapping.qubit2core[ev.qubit] = ev.dst_core;
+      cores.cores[ev.src_core].erase(ev.qubit);
+      cores.cores[ev.dst_core].insert(ev.qubit);
+    }
+}
+
+// ----------------------------------------------------------------------
+void Simulation::chargeEvictions(Statistics& stats, const Architecture& architecture,
+				 const NoC& noc, const Parameters& params)
+{
+  ParallelCommunications pending = eviction_comms;
+
+  while (!pending.empty())
+    {
+      vector<int> available_ltm_ports = architecture.core_ltm_ports;
+      ParallelCommunications round;
+
+      for (auto it = pending.begin(); it != pending.end(); )
+	if (available_ltm_ports[it->src_core] && available_ltm_ports[it->dst_core])
+	  {
+	    available_ltm_ports[it->src_core]--;
+	    available_ltm_ports[it->dst_core]--;
+	    round.push_back(*it);
+	    it = pending.erase(it);
+	  }
+	else
+	  ++it;
+
+      TeleportationTime tp_time = getTeleportationTime(round, noc, params);
+      addTeleportationTime(stats.teleportation_time, tp_time);
+      stats.eviction_time += tp_time.getTotalTeleportationTime();
+    }
+
+  stats.evictions += eviction_comms.size();
+  stats.total_intercore_comms += eviction_comms.size();
+  stats.intercore_volume += getTotalCommunicationVolume(eviction_comms);
+  stats.addIntercoreCommunications(eviction_comms);
+  for (int qb : evicted_qubits)
+    stats.addTeleportationsPerQubit(qb);
+
+  eviction_comms.clear();
+  evicted_qubits.clear();
+}
+
+// ----------------------------------------------------------------------
+// The migrations run in background, in parallel with the slice, in
+// a single teleportation round using the LTM ports left idle by the
+// last round of the slice. The qubits of the slice are not migrated,
+// as they may be still in use (or just teleported) by its gates. Only
+// the part of their teleportation time exceeding the execution time
+// of the slice is exposed.
+void Simulation::rebalance(Statistics& stats, const ParallelGates& pgates,
+			   const ParallelGates& next_pgates,
+			   const Architecture& architecture, const NoC& noc,
+			   const Parameters& params, Mapping& mapping, Cores& cores)
+{
+  if (rebalancer.isTriggered(architecture, cores))
+    rebalancer.plan(architecture, cores, eviction.last_use);
+
+  if (rebalancer.pending.empty())
+    return;
+
+  set<int> busy_qubits;
+  for (const auto& gate : pgates)
+    busy_qubits.insert(gate.second.begin(), gate.second.end());
+  for (const auto& gate : next_pgates)
+    busy_qubits.insert(gate.second.begin(), gate.second.end());
+
+  ParallelCommunications migrations;
+  vector<int>& ports = idle_ltm_ports;
+  for (auto it = rebalancer.pending.begin(); it != rebalancer.pending.end(); )
+    {
+      const Migration& m = *it;
+
+      // The plan is outdated if the qubit has been moved in the
+      // meanwhile or the destination core is full
+      if (!mapping.isMapped(m.qubit) || mapping.qubit2core.at(m.qubit) != m.src_core ||
+	  (int)cores.cores[m.dst_core].size() >= architecture.getCoreCapacity(m.dst_core))
+	{
+	  it = rebalancer.pending.erase(it);
+	  continue;
+	}
+
+      if (busy_qubits.find(m.qubit) != busy_qubits.end() ||
+	  !ports[m.src_core] || !ports[m.dst_core])
+	{
+	  ++it;
+	  continue;
+	}
+
+      ports[m.src_core]--;
+      ports[m.dst_core]--;
+      migrations.push_back(Communication(m.src_core, m.dst_core,
+					 ceil(log2(2+architecture.total_physical_qubits))));
+      stats.addTeleportationsPerQubit(m.qubit);
+      cancelPrefetch(m.qubit);
+
+      mapping.qubit2core[m.qubit] = m.dst_core;
+      cores.cores[m.src_core].erase(m.qubit);
+      cores.cores[m.dst_core].insert(m.qubit);
+
+      it = rebalancer.pending.erase(it);
+    }
+
+  if (migrations.empty())
+    return;
+
+  stats.rebalance_migrations += migrations.size();
+  addBackgroundCommunications(stats, migrations, noc, params,
+			      stats.rebalance_hidden_time, stats.rebalance_exposed_time);
+}
+
+// ----------------------------------------------------------------------
+void Simulation::addBackgroundCommunications(Statistics& stats,
+					     const ParallelCommunications& comms,
+					     const NoC& noc, const Parameters& params,
+					     double& hidden_time, double& exposed_time)
+{
+  double slice_time = stats.getExecutionTime();
+  double tp_time = getTeleportationTime(comms, noc, params).getTotalTeleportationTime();
+  double exposed = max(0.0, tp_time - slice_time);
+
+  hidden_time += tp_time - exposed;
+  exposed_time += exposed;
+  stats.total_intercore_comms += comms.size();
+  stats.intercore_volume += getTotalCommunicationVolume(comms);
+  stats.addIntercoreCommunications(comms);
+}
+
+// ----------------------------------------------------------------------
+// Scans the gates of the next prefetch_slices slices. A remote gate
+// whose qubits are used there for the first time in the window is
+// prepared in advance: its qubits are teleported to the core that
+// would be selected for the gate, using the LTM ports left idle by
+// the current slice. The gates with qubits used by the current slice
+// are skipped, as those qubits may be still in use (or just
+// teleported) there and their move could not be hidden behind it.
+// Only moves that keep a free slot in the destination core are done,
+// so that prefetching never causes evictions. Not supported with
+// TP_TYPE_MESH.
+void Simulation::prefetch(Statistics& stats, const ParallelGates& pgates,
+			  list<ParallelGates>::const_iterator it_next,
+			  list<ParallelGates>::const_iterator it_end,
+			  const Architecture& architecture, const NoC& noc,
+			  const Parameters& params, Mapping& mapping, Cores& cores)
+{
+  if (architecture.teleportation_type == TP_TYPE_MESH)
+    return;
+
+  set<int> seen; // qubits already used in the window
+  set<int> busy; // qubits of the current slice
+  for (const auto& gate : pgates)
+    busy.insert(gate.second.begin(), gate.second.end());
+  ParallelCommunications comms;
+  vector<int>& ports = idle_ltm_ports;
+
+  for (int k = 0; k < architecture.prefetch_slices && it_next != it_end; k++, it_next++)
+    for (const auto& gate : *it_next)
+      {
+	bool first_use = true;
+	for (int qb : gate.second)
+	  if (seen.find(qb) != seen.end() || busy.find(qb) != busy.end())
+	    first_use = false;
+	seen.insert(gate.second.begin(), gate.second.end());
+
+	if (!first_use || gate.second.size() < 2 || isLocalGate(gate, mapping) ||
+	    (architecture.dst_selection_mode == DST_SEL_LOAD_INDEPENDENT && gate.second.size() != 2))
+	  continue;
+
+	int dst_core = selectDestinationCore(architecture, gate, mapping, cores, &ports);
+
+	// All the qubits of the gate are moved or none
+	vector<int> tmp_ports = ports;
+	int incoming = 0;
+	bool feasible = true;
+	for (int qb : gate.second)
+	  {
+	    int src_core = mapping.qubit2CoreSafe(qb);
+	    if (src_core == dst_core)
+	      continue;
+
+	    if (!tmp_ports[src_core] || !tmp_ports[dst_core])
+	      {
+		feasible = false;
+		break;
+	      }
+	    tmp_ports[src_core]--;
+	    tmp_ports[dst_core]--;
+	    incoming++;
+	  }
+
+	if (!feasible ||
+	    (int)cores.cores[dst_core].size() + incoming >= architecture.getCoreCapacity(dst_core))
+	  continue;
+
+	ports = tmp_ports;
+	for (int qb : gate.second)
+	  {
+	    int src_core = mapping.qubit2CoreSafe(qb);
+	    if (src_core == dst_core)
+	      continue;
+
+	    comms.push_back(Communication(src_core, dst_core,
+					  ceil(log2(2+architecture.total_physical_qubits))));
+	    stats.addTeleportationsPerQubit(qb);
+	    cancelPrefetch(qb);
+	    prefetched.insert(qb);
+
+	    mapping.qubit2core[qb] = dst_core;
+	    cores.cores[src_core].erase(qb);
+	    cores.cores[dst_core].insert(qb);
+	  }
+      }
+
+  if (comms.empty())
+    return;
+
+  stats.prefetches += comms.size();
+  addBackgroundCommunications(stats, comms, noc, params,
+			      stats.prefetch_hidden_time, stats.prefetch_exposed_time);
+}
+
+// ----------------------------------------------------------------------
+void Simulation::cancelPrefetch(const int qb)
+{
+  if (prefetched.erase(qb) > 0)
+    prefetch_misspeculations++;
+}
+
+// ----------------------------------------------------------------------
+void Simulation::checkPrefetchHits(const ParallelGates& pgates)
+{
+  for (const auto& gate : pgates)
+    for (int qb : gate.second)
+      if (prefetched.erase(qb) > 0)
+	prefetch_hits++;
+}
+
 // ----------------------------------------------------------------------
 // Generate communications from the core where the qubits of gate are
 // mapped onto to the dst_core and insert them into
@@ -193,46 +800,339 @@ TeleportationTime Simulation::getTeleportationTime(const ParallelCommunications&
 {
   TeleportationTime tt;
 
-  tt.t_epr = params.epr_delay;
-  tt.t_dist = params.dist_delay;
+  // No entanglement and no classical message: the qubits are moved
+  if (shuttling)
+    {
+      tt.t_shuttle = noc.getShuttlingTime(pcomms);
+      return tt;
+    }
+
+  setEPRTime(tt, pcomms, noc, params, entanglement_swapping);
   tt.t_pre = params.pre_delay;
-  tt.t_clas = noc.getCommunicationTime(pcomms);
+  tt.t_clas = getPacketizedCommunicationTime(pcomms, noc);
   tt.t_post = params.post_delay;
+
+  if (entanglement_swapping)
+    {
+      // The swaps at the intermediate cores are done in parallel. Each
+      // core adds its outcome to the teleportation message crossing
+      // it, thus a single message set is needed.
+      for (const auto& comm : pcomms)
+	if (getCorePath(comm.src_core, comm.dst_core, 0, noc).size() > 2)
+	  {
+	    tt.t_swap = params.swap_delay;
+	    break;
+	  }
+    }
   
   return tt;
 }
 
+// ----------------------------------------------------------------------
+void Simulation::setEPRTime(TeleportationTime& tt, const ParallelCommunications& pcomms,
+			    const NoC& noc, const Parameters& params, const bool swapping)
+{
+  if (noc.qlink_channels > 0)
+    noc.getEPRDistributionTime(pcomms, swapping, tt.t_epr, tt.t_dist);
+  else
+    {
+      tt.t_epr = params.epr_delay;
+      tt.t_dist = params.dist_delay;
+    }
+}
+
+// ----------------------------------------------------------------------
+double Simulation::getHopChainTime(const ParallelCommunications& pcomms,
+				   const NoC& noc, const Parameters& params)
+{
+  NoCState saved_noc = noc.saveState();
+  long saved_coalesced_messages = coalesced_messages;
+  long saved_coalesced_packets = coalesced_packets;
+  double saved_coalescing_saved_time = coalescing_saved_time;
+
+  vector<vector<int> > paths;
+  size_t max_len = 0;
+  for (const auto& comm : pcomms)
+    {
+      paths.push_back(getCorePath(comm.src_core, comm.dst_core, 0, noc));
+      max_len = max(max_len, paths.back().size());
+    }
+
+  // the k-th round moves the qubits from the (k-1)-th to the k-th
+  // core of their paths
+  double t = 0.0;
+  for (size_t k = 1; k < max_len; k++)
+    {
+      ParallelCommunications hop;
+      auto it = pcomms.begin();
+      for (const auto& path : paths)
+	{
+	  if (k < path.size())
+	    hop.push_back(Communication(path[k-1], path[k], it->volume));
+	  ++it;
+	}
+
+      TeleportationTime tt;
+      setEPRTime(tt, hop, noc, params, false);
+      tt.t_pre = params.pre_delay;
+      tt.t_clas = getPacketizedCommunicationTime(hop, noc);
+      tt.t_post = params.post_delay;
+      t += tt.getTotalTeleportationTime();
+    }
+
+  noc.restoreState(saved_noc);
+  coalesced_messages = saved_coalesced_messages;
+  coalesced_packets = saved_coalesced_packets;
+  coalescing_saved_time = saved_coalescing_saved_time;
+
+  return t;
+}
+
+// ----------------------------------------------------------------------
+double Simulation::getPacketizedCommunicationTime(const ParallelCommunications& pcomms,
+						  const NoC& noc)
+{
+  ParallelCommunications packets = noc.packetize(pcomms);
+  double t = noc.getCommunicationTime(packets);
+
+  if (noc.coalescing && !pcomms.empty())
+    {
+      coalesced_messages += pcomms.size();
+      coalesced_packets += packets.size();
+      coalescing_saved_time += noc.getUncoalescedCommunicationTime(pcomms) - t;
+    }
+
+  return t;
+}
+
 // ----------------------------------------------------------------------
 void Simulation::addTeleportationTime(TeleportationTime& total_tt,
 				      const TeleportationTime& tt)
 {
   total_tt.t_epr  += tt.t_epr;
   total_tt.t_dist += tt.t_dist;
+  total_tt.t_swap += tt.t_swap;
   total_tt.t_pre  += tt.t_pre;
   total_tt.t_clas += tt.t_clas;
   total_tt.t_post += tt.t_post;
+  total_tt.t_shuttle += tt.t_shuttle;
+  total_tt.t_pool += tt.t_pool;
 }
 
 // ----------------------------------------------------------------------
 void Simulation::updateRemoteExecutionStats(Statistics& stats,
 				const ParallelGates& pgates,
 				const ParallelCommunications& pcomms,
-				const NoC& noc,
-				const Parameters& params)
+				const ParallelCommunications& return_comms,
+				const Architecture& architecture, const NoC& noc,
+				const Parameters& params,
+				const Mapping& mapping, const Cores& cores)
 {
   stats.executed_gates += pgates.size();
+  stats.remote_gates += pgates.size();
 
-  stats.total_intercore_comms += pcomms.size();
+  stats.total_intercore_comms += pcomms.size() + return_comms.size();
 
-  stats.intercore_volume += getTotalCommunicationVolume(pcomms);
+  stats.intercore_volume += getTotalCommunicationVolume(pcomms) +
+    getTotalCommunicationVolume(return_comms);
     
   TeleportationTime tp_time = getTeleportationTime(pcomms, noc, params);
+
+  // Only the rounds of the remote gates are compared with the hop
+  // chain, not the background and eviction traffic
+  if (entanglement_swapping && !pcomms.empty())
+    {
+      for (const auto& comm : pcomms)
+	swaps_per_path[max(0, (int)getCorePath(comm.src_core, comm.dst_core, 0, noc).size() - 2)]++;
+      swapping_time += tp_time.getTotalTeleportationTime();
+      hop_chain_time += getHopChainTime(pcomms, noc, params);
+    }
+
+  // shuttled ions do not use EPR pairs
+  if (cores.comm_capacity > 0 && !shuttling)
+    {
+      tp_time.t_pool = getCommPoolStallTime(pgates, pcomms, tp_time.getTotalTeleportationTime(),
+					    mapping, cores);
+      if (tp_time.t_pool > 0.0)
+	stats.comm_stalled_rounds++;
+    }
+
+  // The return messages of the telegates follow the gates
+  double t_return = 0.0;
+  if (!return_comms.empty())
+    {
+      t_return = getPacketizedCommunicationTime(return_comms, noc);
+      tp_time.t_clas += t_return;
+    }
   				       
   addTeleportationTime(stats.teleportation_time, tp_time);
 
+  // The time of the round is shared by its gates, but the return
+  // messages are charged to the telegates only. A round gathering
+  // the qubits of a gate without executing it is teledata.
+  int telegates = return_comms.size();
+  double t_shared = tp_time.getTotalTeleportationTime() - t_return;
+  stats.telegates += telegates;
+  if (pgates.empty())
+    stats.teledata_time += t_shared;
+  else
+    {
+      double share = t_shared / pgates.size();
+      stats.telegate_time += share * telegates + t_return;
+      stats.teledata_time += share * (pgates.size() - telegates);
+    }
+
   stats.addIntercoreCommunications(pcomms);
+  stats.addIntercoreCommunications(return_comms);
   
-  stats.computation_time += getMaxGateLatency(pgates, params.gate_delays);
+  if (!pgates.empty())
+    stats.computation_time += getLocalGatesLatency(pgates, architecture, params,
+						   mapping, cores, stats);
+}
+
+// ----------------------------------------------------------------------
+double Simulation::getCommPoolStallTime(const ParallelGates& pgates,
+					const ParallelCommunications& pcomms,
+					const double t_round, const Mapping& mapping,
+					const Cores& cores)
+{
+  int ncores = cores.getNumCores();
+  vector<int> needed(ncores, 0), relays(ncores, 0);
+
+  for (const auto& comm : pcomms)
+    {
+      needed[comm.src_core]++;
+      needed[comm.dst_core]++;
+    }
+
+  for (const auto& gate : pgates)
+    for (int qb : gate.second)
+      if (cores.isCommQubit(qb))
+	{
+	  int core_id = mapping.qubit2CoreSafe(qb);
+	  relays[core_id]++;
+	  needed[core_id] = max(0, needed[core_id] - 1);
+	}
+
+  int waves = 1;
+  for (int c = 0; c < ncores; c++)
+    {
+      // the waiting relays used in the round need a free one too
+      needed[c] += min(relays[c], cores.getCommWaiting(c));
+      int free_qubits = max(0, cores.comm_capacity - cores.comm_used[c]);
+      comm_peak[c] = max(comm_peak[c],
+			 min(cores.comm_used[c], cores.comm_capacity) + min(needed[c], free_qubits));
+      if (needed[c] <= free_qubits)
+	continue;
+
+      // after the first wave also the relays used are free
+      int per_wave = max(1, free_qubits + relays[c]);
+      waves = max(waves, 1 + (needed[c] - free_qubits + per_wave - 1) / per_wave);
+    }
+
+  return (waves - 1) * t_round;
+}
+
+// ----------------------------------------------------------------------
+bool Simulation::useTelegate(const Architecture& architecture, const Parameters& params,
+			     const Gate& gate, const Mapping& mapping, const Cores& cores,
+			     const vector<int>& available_ltm_ports)
+{
+  if (architecture.remote_gate_mode == REMOTE_TELEDATA ||
+      architecture.teleportation_type == TP_TYPE_MESH ||
+      architecture.teleportation_type == TP_TYPE_SHUTTLE || gate.second.size() != 2 ||
+      mapping.qubit2CoreSafe(gate.second.front()) == mapping.qubit2CoreSafe(gate.second.back()))
+    return false;
+
+  if (architecture.remote_gate_mode == REMOTE_TELEGATE)
+    return true;
+
+  return (getTelegateCost(architecture, params, gate, mapping, available_ltm_ports) <=
+	  getTeledataCost(architecture, params, gate, mapping, cores, available_ltm_ports));
+}
+
+// ----------------------------------------------------------------------
+double Simulation::getTeleportationEstimate(const Architecture& architecture,
+					    const Parameters& params,
+					    const int src_core, const int dst_core)
+{
+  const NoC& noc = architecture.noc;
+  int volume = ceil(log2(2+architecture.total_physical_qubits));
+  int hops = noc.getHopDistance(src_core, dst_core);
+
+  double t = params.epr_delay + params.dist_delay + params.pre_delay + params.post_delay +
+    hops * noc.linkTraversalCycles(volume) * noc.clock_time;
+  if (architecture.teleportation_type == TP_TYPE_SWAP && hops > 1)
+    t += params.swap_delay;
+
+  return t;
+}
+
+// ----------------------------------------------------------------------
+double Simulation::getTelegateCost(const Architecture& architecture, const Parameters& params,
+				   const Gate& gate, const Mapping& mapping,
+				   const vector<int>& available_ltm_ports)
+{
+  const NoC& noc = architecture.noc;
+  int volume = ceil(log2(2+architecture.total_physical_qubits));
+  int core_a = mapping.qubit2CoreSafe(gate.second.front());
+  int core_b = mapping.qubit2CoreSafe(gate.second.back());
+
+  double t_round = getTeleportationEstimate(architecture, params, core_a, core_b);
+  double cost = t_round +
+    noc.getHopDistance(core_b, core_a) * noc.linkTraversalCycles(volume) * noc.clock_time;
+
+  if (!available_ltm_ports[core_a] || !available_ltm_ports[core_b])
+    cost += t_round;
+
+  return cost;
+}
+
+// ----------------------------------------------------------------------
+double Simulation::getTeledataCost(const Architecture& architecture, const Parameters& params,
+				   const Gate& gate, const Mapping& mapping, const Cores& cores,
+				   const vector<int>& available_ltm_ports)
+{
+  const list<int> no_exclude;
+  int dst_core = selectDestinationCore(architecture, gate, mapping, cores, &available_ltm_ports);
+  vector<int> ports = available_ltm_ports;
+  double t_round = 0.0, t_return = 0.0;
+  bool postponed = false;
+  int incoming = 0;
+
+  for (int qb : gate.second)
+    {
+      int src_core = mapping.qubit2CoreSafe(qb);
+      if (src_core == dst_core)
+	continue;
+
+      double t_move = getTeleportationEstimate(architecture, params, src_core, dst_core);
+      t_round = max(t_round, t_move);
+      incoming++;
+
+      if (ports[src_core] && ports[dst_core])
+	{
+	  ports[src_core]--;
+	  ports[dst_core]--;
+	}
+      else
+	postponed = true;
+
+      double aff_src = lookahead.affinity(qb, src_core, current_slice,
+					  architecture.lookahead_slices,
+					  architecture.lookahead_discount, mapping, no_exclude);
+      double aff_dst = lookahead.affinity(qb, dst_core, current_slice,
+					  architecture.lookahead_slices,
+					  architecture.lookahead_discount, mapping, no_exclude);
+      if (aff_src > 0.0)
+	t_return += aff_src / (aff_src + aff_dst) *
+	  getTeleportationEstimate(architecture, params, dst_core, src_core);
+    }
+
+  int evictions = max(0, (int)cores.cores[dst_core].size() + incoming -
+		      architecture.getCoreCapacity(dst_core));
+
+  return t_round * (postponed ? 2 : 1) + evictions * t_round + t_return;
 }
 
 // ----------------------------------------------------------------------
@@ -245,6 +1145,46 @@ void Simulation::removeExecutedGates(const ParallelGates& scheduled_gates,
     });
 }
 
+// ----------------------------------------------------------------------
+ParallelGates Simulation::orderRemoteGates(const Architecture& architecture,
+					   const ParallelGates& gates,
+					   const Mapping& mapping, const Cores& cores)
+{
+  if (architecture.packing_policy == PACK_GREEDY)
+    return gates;
+
+  vector<const Gate*> vgates;
+  vector<vector<int> > demands;
+  vector<int> criticality;
+  for (const auto& gate : gates)
+    {
+      int dst_core = selectDestinationCore(architecture, gate, mapping, cores);
+      vector<int> demand;
+      int depth = 0;
+      for (const auto& qb : gate.second)
+	{
+	  int src_core = mapping.qubit2CoreSafe(qb);
+	  if (src_core != dst_core)
+	    {
+	      demand.push_back(src_core);
+	      demand.push_back(dst_core);
+	    }
+	  if (architecture.packing_policy == PACK_CRITICAL_FIRST)
+	    depth = max(depth, lookahead.remainingDepth(qb, current_slice));
+	}
+
+      vgates.push_back(&gate);
+      demands.push_back(demand);
+      criticality.push_back(depth);
+    }
+
+  ParallelGates ordered;
+  for (int g : packer.order(architecture, demands, criticality))
+    ordered.push_back(*vgates[g]);
+
+  return ordered;
+}
+
 // ----------------------------------------------------------------------
 Statistics Simulation::remoteExecution(const Architecture& architecture, const NoC& noc,
 				       const Parameters& parameters,
@@ -260,19 +1200,57 @@ Statistics Simulation::remoteExecution(const Architecture& architecture, const N
   if (!rgates.empty())
     {
       ParallelGates gates = rgates;
+      map<Gate,int> gathering; // gates partially gathered --> their core
 
       while (!gates.empty())
 	{
-	  vector<int> available_ltm_ports(architecture.number_of_cores, architecture.ltm_ports);
+	  stats.remote_rounds++;
+	  ParallelGates round_gates = orderRemoteGates(architecture, gates, mapping, cores);
+	  vector<int> available_ltm_ports = architecture.core_ltm_ports;
 	  ParallelGates parallel_gates;
 	  ParallelCommunications parallel_communications;
+	  ParallelCommunications return_communications;
+
+	  // The qubits of the gates scheduled in this round and of those
+	  // partially gathered cannot be evicted
+	  set<int> round_protected;
+	  for (const auto& gg : gathering)
+	    round_protected.insert(gg.first.second.begin(), gg.first.second.end());
 	  
 	  bool first_gate_to_map = true;
-	  for (const auto& gate : gates)
+	  for (const auto& gate : round_gates)
 	    {
+	      if (useTelegate(architecture, parameters, gate, mapping, cores, available_ltm_ports))
+		{
+		  // A single EPR pair and no migration: the control core
+		  // sends the outcome of the cat-entangler to the target
+		  // core, which sends back that of the disentangler
+		  int core_a = mapping.qubit2core[gate.second.front()];
+		  int core_b = mapping.qubit2core[gate.second.back()];
+		  if (available_ltm_ports[core_a] && available_ltm_ports[core_b])
+		    {
+		      int volume = ceil(log2(2+architecture.total_physical_qubits));
+		      available_ltm_ports[core_a]--;
+		      available_ltm_ports[core_b]--;
+		      parallel_communications.push_back(Communication(core_a, core_b, volume));
+		      return_communications.push_back(Communication(core_b, core_a, volume));
+		      round_protected.insert(gate.second.begin(), gate.second.end());
+		      parallel_gates.push_back(gate);
+		      remote_gates_per_qubits[gate.second.size()]++;
+		    }
+		  else if (first_gate_to_map)
+		    FATAL("at least the first gate of the parallel_gates must be mapped!");
+
+		  first_gate_to_map = false;
+		  continue;
+		}
+
 	      bool skip_this_gate = false;
-	      int dst_core = selectDestinationCore(architecture, gate, mapping, cores);
+	      auto it_gathering = gathering.find(gate);
+	      int dst_core = (it_gathering != gathering.end()) ? it_gathering->second :
+		selectDestinationCore(architecture, gate, mapping, cores, &available_ltm_ports);
 	      vector<int> tmp_available_ltm_ports = available_ltm_ports;
+	      list<int> moving; // qubits teleported to dst_core
 	      for (const auto& qb : gate.second)
 		{		  
 		  int src_core = mapping.qubit2core[qb];
@@ -283,13 +1261,11 @@ Statistics Simulation::remoteExecution(const Architecture& architecture, const N
 			  // qb can be teleported from src_core to dst_core
 			  tmp_available_ltm_ports[src_core]--;
 			  tmp_available_ltm_ports[dst_core]--;
-
-			  // If we reach this point it means the qb will be teleported
-			  stats.addTeleportationsPerQubit(qb);
+			  moving.push_back(qb);
 			}
 		      else
 			{
-			  if (first_gate_to_map)
+			  if (first_gate_to_map && moving.empty())
 			    FATAL("at least the first gate of the parallel_gates must be mapped!");
 			  			  
 			  skip_this_gate = true;
@@ -298,25 +1274,50 @@ Statistics Simulation::remoteExecution(const Architecture& architecture, const N
 		    }
 		} // for (const auto& qb : gate.second)
 
-	      if (!skip_this_gate)
+	      // The qubits of the first gate are gathered in dst_core in
+	      // several rounds if the LTM ports are not enough (gates of
+	      // 3+ qubits). The gate is executed in the last round.
+	      bool partial = (skip_this_gate && first_gate_to_map);
+
+	      if (!skip_this_gate || partial)
 		{
+		  Gate moving_gate(gate.first, moving);
+		  round_protected.insert(gate.second.begin(), gate.second.end());
+		  makeRoom(architecture, mapping, cores, dst_core, moving.size(), round_protected);
+
+		  for (int qb : moving)
+		    stats.addTeleportationsPerQubit(qb);
+
 		  // IMPORTANT: addParallelCommunication must be called before updateMappingAndCores
-		  addParallelCommunications(parallel_communications, gate, dst_core, mapping,
-					    ceil(log2(2+architecture.qubits_per_core*architecture.number_of_cores))); 
+		  addParallelCommunications(parallel_communications, moving_gate, dst_core, mapping,
+					    ceil(log2(2+architecture.total_physical_qubits))); 
 		  available_ltm_ports = tmp_available_ltm_ports;
-		  parallel_gates.push_back(gate);
-		  updateMappingAndCores(architecture, mapping, cores, gate, dst_core);
+		  updateMappingAndCores(architecture, mapping, cores, moving_gate, dst_core);
+
+		  if (partial)
+		    gathering[gate] = dst_core;
+		  else
+		    {
+		      parallel_gates.push_back(gate);
+		      gathering.erase(gate);
+		      if (architecture.teleportation_type != TP_TYPE_MESH)
+			remote_gates_per_qubits[gate.second.size()]++;
+		    }
 		}
 
 	      first_gate_to_map = false;
 
 	    } // for (const auto& gate : gates)
 	  
+	  idle_ltm_ports = available_ltm_ports;
 	  updateRemoteExecutionStats(stats, parallel_gates, parallel_communications,
-				     noc, parameters);
+				     return_communications, architecture, noc, parameters, mapping, cores);
 	  cores.saveHistory();
 	  removeExecutedGates(parallel_gates, gates);
 	} //  while (!gates.empty())
+
+      stats.remote_slices = 1;
+      stats.max_remote_rounds = stats.remote_rounds;
     }
   
   return stats;
@@ -331,6 +1332,17 @@ Statistics Simulation::mergeLocalRemoteStatistics(const Statistics& stats_local,
 
   // TODO: check this function!!!
   stats.executed_gates = stats_local.executed_gates + stats_remote.executed_gates;
+  stats.remote_gates = stats_remote.remote_gates;
+  stats.telegates = stats_remote.telegates;
+  stats.comm_stalled_rounds = stats_remote.comm_stalled_rounds;
+  stats.teledata_time = stats_remote.teledata_time;
+  stats.telegate_time = stats_remote.telegate_time;
+  stats.local_swaps = stats_local.local_swaps + stats_remote.local_swaps;
+  stats.local_swap_time = stats_local.local_swap_time + stats_remote.local_swap_time;
+  stats.remote_rounds = stats_remote.remote_rounds;
+  stats.remote_slices = stats_remote.remote_slices;
+  stats.max_remote_rounds = stats_remote.max_remote_rounds;
+  stats.total_intercore_comms = stats_remote.total_intercore_comms;
   stats.intercore_comms = stats_remote.intercore_comms;
   stats.intercore_volume = stats_remote.intercore_volume;
   
@@ -358,16 +1370,24 @@ Statistics Simulation::mergeLocalRemoteStatistics(const Statistics& stats_local,
 void Simulation::fetchContribution(Statistics& stats,
 				   const ParallelGates& pgates,
 				   const Architecture& architecture,
-				   const Parameters& parameters)
+				   const Parameters& parameters,
+				   const Mapping& mapping)
 {
-  int bundle_size = 0;
-  int total_qubits = architecture.qubits_per_core * architecture.number_of_cores;
+  // Each MI fetches the instructions of its cores. MIs fetch in
+  // parallel.
+  const MemoryInterfaces& mis = architecture.memory_interfaces;
+  vector<int> bundle_size(mis.getNumMIs(), 0);
+  int total_qubits = architecture.total_physical_qubits;
   int bits_qubit_addr = ceil(log2(total_qubits));
   
   for (Gate g : pgates)
-    bundle_size += parameters.bits_instruction + g.second.size() * bits_qubit_addr;
+    {
+      int mi = mis.mi_of_core[getDispatchCore(g, mapping)];
+      bundle_size[mi] += parameters.bits_instruction + g.second.size() * bits_qubit_addr;
+    }
 
-  stats.fetch_time = bundle_size / parameters.memory_bandwidth;
+  stats.fetch_time = *max_element(bundle_size.begin(), bundle_size.end()) /
+    parameters.memory_bandwidth;
 }
 
 // ----------------------------------------------------------------------
@@ -385,37 +1405,168 @@ ParallelCommunications Simulation::makeDispatchCommunications(const ParallelGate
 							      const Parameters& parameters,
 							      const Mapping& mapping)
 {
-  int bits_qubit_laddr = ceil(log2(architecture.qubits_per_core));
+  int bits_qubit_laddr = ceil(log2(architecture.getMaxCoreCapacity()));
   ParallelCommunications pc;
   
   for (Gate g : pgates)
     {
+      // a local address per qubit of the gate
       int volume = parameters.bits_instruction + g.second.size() * bits_qubit_laddr;
-      // all the qubits of gate in lgates are in the same core. Thus,
-      // to determine the target core. The target core cannot be
-      // inferred from the gate in general. For the case of
-      // teleportation_type == MESH the target core is that hosting
-      // the qubit in the secon input of the gate.
-      
-      assert(g.second.size() <= 2);
-      auto it = g.second.begin(); 
-      advance(it, 1);    
-      int qb = *it;      
-      int dst_core = mapping.qubit2CoreSafe(qb);
-      Communication comm(0, dst_core, volume);
+      int dst_core = getDispatchCore(g, mapping);
+      const MemoryInterfaces& mis = architecture.memory_interfaces;
+      Communication comm(mis.cores[mis.mi_of_core[dst_core]], dst_core, volume);
       pc.push_back(comm);
     }
 
   return pc;
 }
 
-// Returns all the communications into pcomms except those (0,0)
-ParallelCommunications Simulation::removeMI2Node0Communications(const ParallelCommunications& pcomms)
+// ----------------------------------------------------------------------
+// The fingerprint of a bundle hashes the operations and the qubits of
+// its gates in the order of the slice
+ParallelGates Simulation::filterCachedInstructions(Statistics& stats,
+						   const ParallelGates& pgates,
+						   const Architecture& architecture,
+						   const Parameters& parameters,
+						   const Mapping& mapping)
+{
+  int bits_qubit_laddr = ceil(log2(architecture.getMaxCoreCapacity()));
+  map<int,string> bundle; // core -> serialized bundle
+  map<int,int> bundle_bits;
+
+  for (const Gate& g : pgates)
+    {
+      int core = getDispatchCore(g, mapping);
+      string& s = bundle[core];
+      s += g.first;
+      for (int qb : g.second)
+	s += " " + to_string(qb);
+      s += ";";
+      bundle_bits[core] += parameters.bits_instruction + g.second.size() * bits_qubit_laddr;
+    }
+
+  set<int> missed_cores;
+  for (const auto& b : bundle)
+    {
+      stats.icache_lookups++;
+      if (icache.access(b.first, hash<string>()(b.second), bundle_bits[b.first]))
+	stats.icache_hits++;
+      else
+	missed_cores.insert(b.first);
+    }
+
+  ParallelGates missed;
+  for (const Gate& g : pgates)
+    if (missed_cores.find(getDispatchCore(g, mapping)) != missed_cores.end())
+      missed.push_back(g);
+
+  return missed;
+}
+
+// ----------------------------------------------------------------------
+double Simulation::getDispatchTimeWithoutCache(const ParallelGates& pgates,
+					       const Architecture& architecture,
+					       const Parameters& parameters,
+					       const Mapping& mapping)
+{
+  NoCState saved_noc = architecture.noc.saveState();
+  long saved_coalesced_messages = coalesced_messages;
+  long saved_coalesced_packets = coalesced_packets;
+  double saved_coalescing_saved_time = coalescing_saved_time;
+  vector<long> saved_mi_instructions = mi_instructions;
+  vector<long> saved_mi_dispatch_volume = mi_dispatch_volume;
+  vector<double> saved_mi_transfer_time = mi_transfer_time;
+
+  Statistics stats;
+  dispatchContribution(stats, pgates, architecture, parameters, mapping);
+
+  architecture.noc.restoreState(saved_noc);
+  coalesced_messages = saved_coalesced_messages;
+  coalesced_packets = saved_coalesced_packets;
+  coalescing_saved_time = saved_coalescing_saved_time;
+  mi_instructions = saved_mi_instructions;
+  mi_dispatch_volume = saved_mi_dispatch_volume;
+  mi_transfer_time = saved_mi_transfer_time;
+
+  return stats.dispatch_time;
+}
+
+// ----------------------------------------------------------------------
+int Simulation::getDispatchCore(const Gate& gate, const Mapping& mapping)
+{
+  return mapping.qubit2CoreSafe(gate.second.size() > 1 ?
+				*next(gate.second.begin()) : gate.second.front());
+}
+
+// ----------------------------------------------------------------------
+// The gates of the slice with the same operation served by the same
+// memory interface are dispatched by a single multicast to the cores
+// hosting them. The instruction is shared by all the cores, while
+// the local addresses of the qubits of a gate are addressed to its
+// core only.
+ParallelCommunications Simulation::makeDispatchMulticasts(const ParallelGates& pgates,
+							  const Architecture& architecture,
+							  const Parameters& parameters,
+							  const Mapping& mapping)
+{
+  const MemoryInterfaces& mis = architecture.memory_interfaces;
+  int bits_qubit_laddr = ceil(log2(architecture.getMaxCoreCapacity()));
+  typedef pair<int,string> MIOperation;
+  map<MIOperation, pair<vector<int>, vector<int> > > groups; // (MI, operation) -> (cores, volumes)
+  vector<MIOperation> order; // groups in order of appearance
+
+  for (const Gate& g : pgates)
+    {
+      int dst_core = getDispatchCore(g, mapping);
+      MIOperation key(mis.mi_of_core[dst_core], g.first);
+
+      auto it = groups.find(key);
+      if (it == groups.end())
+	{
+	  it = groups.insert(make_pair(key, make_pair(vector<int>(), vector<int>()))).first;
+	  order.push_back(key);
+	}
+
+      vector<int>& cores = it->second.first;
+      vector<int>& volumes = it->second.second;
+      unsigned int i = find(cores.begin(), cores.end(), dst_core) - cores.begin();
+      if (i == cores.size())
+	{
+	  cores.push_back(dst_core);
+	  volumes.push_back(0);
+	}
+      volumes[i] += g.second.size() * bits_qubit_laddr;
+    }
+
+  ParallelCommunications pc;
+  for (const MIOperation& key : order)
+    pc.push_back(Communication(mis.cores[key.first], groups[key].first, groups[key].second,
+			       parameters.bits_instruction));
+
+  return pc;
+}
+
+// Returns all the dispatch communications into pcomms except those
+// from a MI to the core it is attached to (src == dst)
+ParallelCommunications Simulation::removeMI2NodeCommunications(const ParallelCommunications& pcomms)
 {
   ParallelCommunications filtered;
 
     for (const auto& comm : pcomms)
-      if (!(comm.src_core == 0 && comm.dst_core == 0))
+      if (comm.isMulticast())
+	{
+	  vector<int> dsts, dst_vols;
+	  for (unsigned int i = 0; i < comm.dst_cores.size(); i++)
+	    if (comm.dst_cores[i] != comm.src_core)
+	      {
+		dsts.push_back(comm.dst_cores[i]);
+		dst_vols.push_back(comm.dst_volumes[i]);
+	      }
+	  if (!dsts.empty())
+	    filtered.push_back(Communication(comm.src_core, dsts, dst_vols,
+					     comm.getSharedVolume()));
+	}
+      else if (comm.src_core != comm.dst_core)
 	filtered.push_back(comm);
 
     return filtered;
@@ -423,37 +1574,40 @@ ParallelCommunications Simulation::removeMI2Node0Communications(const ParallelCo
 
 // ----------------------------------------------------------------------
 /* 
-   We assume that the memory interface (MI) is connected to core 0.
+   Each memory interface (MI) is connected to a core (node m, see
+   memory_interface.h) and dispatches the instructions of the cores
+   assigned to it.
 
-   Note: Communications from the memory interface to the NoC/WiNoC use
-   source node ID 0. This can be misleading, as it becomes unclear
-   whether a message originating from node 0 is actually from the MI
-   or from core 0. Thus, dispatch communications are represented as
-   (0, dst).
+   Note: Communications from a memory interface to the NoC/WiNoC use
+   the source node ID m. This can be misleading, as it becomes unclear
+   whether a message originating from node m is actually from the MI
+   or from core m. Thus, dispatch communications are represented as
+   (m, dst).
 
    Wired case:
-   If dst != 0, we compute the communication time from node 0 to dst,
-   and then add the transfer time from the MI to node 0:
+   If dst != m, we compute the communication time from node m to dst,
+   and then add the transfer time from the MI to node m:
 
    stats.dispatch_time += noc.getTransferTime(getTotalCommunicationVolume(pcomms));
 
-   However, if dst == 0, this transfer time is counted
-   twice. Communications of the form (0, 0) are included both in
+   However, if dst == m, this transfer time is counted
+   twice. Communications of the form (m, m) are included both in
    noc.getCommunicationTime(pcomms) and in
    noc.getTransferTime(getTotalCommunicationVolume(pcomms)). As a
    result, the dispatch time for the wired case is overestimated.
 
-   To correct this, we remove the (0, 0) communications from the
+   To correct this, we remove the (m, m) communications from the
    pcomms and compute the NoC delay using the filtered communication
    traffic (fpcomms). Then, we update dispatch_time with the delay due
-   to the transfer from the MI to node 0.
+   to the transfer from the MIs to their nodes. The MIs transfer in
+   parallel, thus the slowest one is considered.
 
    Wireless case:
-   In this case, communications of the form (0, 0) do not pose a
+   In this case, communications of the form (m, m) do not pose a
    significant issue. The only minor inaccuracy arises from assuming
-   there are ncores WIs instead of (ncores + 1). This makes the token
-   ring slightly shorter than it should be, leading to a slightly
-   optimistic estimation.
+   there are ncores WIs instead of (ncores + number of MIs). This
+   makes the token ring slightly shorter than it should be, leading
+   to a slightly optimistic estimation.
 */
 void Simulation::dispatchContribution(Statistics& stats,
 				      const ParallelGates& pgates,
@@ -461,23 +1615,43 @@ void Simulation::dispatchContribution(Statistics& stats,
 				      const Parameters& parameters,
 				      const Mapping& mapping)
 {  
-  ParallelCommunications pcomms = makeDispatchCommunications(pgates, architecture, parameters, mapping);
+  ParallelCommunications pcomms = architecture.noc.multicast ?
+    makeDispatchMulticasts(pgates, architecture, parameters, mapping) :
+    makeDispatchCommunications(pgates, architecture, parameters, mapping);
 
+  const MemoryInterfaces& mis = architecture.memory_interfaces;
+
+  // Dispatch load of each MI
+  for (const Gate& g : pgates)
+    mi_instructions[mis.mi_of_core[getDispatchCore(g, mapping)]]++;
+
+  vector<int> mi_volume(mis.getNumMIs(), 0);
+  for (const auto& packet : architecture.noc.packetize(pcomms))
+    mi_volume[mis.mi_of_core[packet.dst_core]] += packet.volume;
+  for (int i = 0; i < mis.getNumMIs(); i++)
+    mi_dispatch_volume[i] += mi_volume[i];
 
   if (architecture.noc.winoc)
     {
-      stats.dispatch_time = architecture.noc.getCommunicationTime(pcomms);
+      stats.dispatch_time = getPacketizedCommunicationTime(pcomms, architecture.noc);
     }
   else
     {
-      // Remove communications from MI to core 0 as their latency contribution will be computed apart
-      ParallelCommunications fpcomms = removeMI2Node0Communications(pcomms);
+      // Remove communications from the MIs to their cores as their latency contribution will be computed apart
+      ParallelCommunications fpcomms = removeMI2NodeCommunications(pcomms);
 
-      // Compute the latencty contribution of the dispatch from core 0 connected to the MI to the other cores
-      stats.dispatch_time = architecture.noc.getCommunicationTime(fpcomms);
+      // Compute the latencty contribution of the dispatch from the cores connected to the MIs to the other cores
+      stats.dispatch_time = getPacketizedCommunicationTime(fpcomms, architecture.noc);
       
-      // Add the latency contribution of the transmissions from MI to core 0
-      stats.dispatch_time += architecture.noc.getTransferTime(getTotalCommunicationVolume(pcomms));
+      // Add the latency contribution of the transmissions from the MIs to their cores
+      double transfer_time = 0.0;
+      for (int i = 0; i < mis.getNumMIs(); i++)
+	{
+	  double t = mis.getTransferTime(architecture.noc, mi_volume[i]);
+	  mi_transfer_time[i] += t;
+	  transfer_time = max(transfer_time, t);
+	}
+      stats.dispatch_time += transfer_time;
     }
 
   stats.total_intercore_comms += pcomms.size();
@@ -492,22 +1666,48 @@ Statistics Simulation::simulate(const ParallelGates& pgates, const Architecture&
 {
   ParallelGates lgates, rgates;
 
+  eviction.touch(pgates);
+  for (int used : cores.comm_used)
+    comm_occupancy += used;
+  comm_samples++;
+  idle_ltm_ports = architecture.core_ltm_ports;
+
   splitLocalRemoteGates(pgates, mapping, lgates, rgates);  
   
   assert(!rgates.empty() || !lgates.empty());
 
-  Statistics stats_local = localExecution(lgates, parameters);
+  Statistics stats_local = localExecution(lgates, architecture, parameters, mapping, cores);
 
   Statistics stats_remote = remoteExecution(architecture, noc, parameters,
 					    rgates, mapping, cores);
 
+  // Qubits still where they have been prefetched are used now
+  checkPrefetchHits(pgates);
+
   Statistics stats_overall = mergeLocalRemoteStatistics(stats_local, stats_remote);
 
-  fetchContribution(stats_overall, pgates, architecture, parameters);
+  chargeEvictions(stats_overall, architecture, noc, parameters);
+
+  // Bundles replayed from the instruction buffers of the cores are
+  // neither fetched nor dispatched
+  ParallelGates fgates = icache.isEnabled() ?
+    filterCachedInstructions(stats_overall, pgates, architecture, parameters, mapping) : pgates;
+
+  fetchContribution(stats_overall, fgates, architecture, parameters, mapping);
 
   decodeContribution(stats_overall, pgates, parameters);
 
-  dispatchContribution(stats_overall, pgates, architecture, parameters, mapping);
+  dispatchContribution(stats_overall, fgates, architecture, parameters, mapping);
+
+  if (fgates.size() < pgates.size())
+    {
+      Statistics uncached;
+      fetchContribution(uncached, pgates, architecture, parameters, mapping);
+      stats_overall.icache_fetch_saved_time = uncached.fetch_time - stats_overall.fetch_time;
+      stats_overall.icache_dispatch_saved_time =
+	getDispatchTimeWithoutCache(pgates, architecture, parameters, mapping) -
+	stats_overall.dispatch_time;
+    }
 		       
   return stats_overall;
 }
@@ -519,7 +1719,10 @@ void Simulation::freeAncillas(const set<int>& ancilla, Mapping& mapping, Cores&
     {
       int core_id = mapping.qubit2CoreSafe(qba);
 
-      cores.cores[core_id].erase(qba);
+      if (cores.isCommQubit(qba))
+	cores.releaseCommQubit(core_id, qba);
+      else
+	cores.cores[core_id].erase(qba);
       mapping.qubit2core.erase(qba);
     }
 }
@@ -583,6 +1786,46 @@ Statistics Simulation::simulate(const Circuit& circuit, const Architecture& arch
 
   // run simulation
   Statistics global_stats(architecture.number_of_cores);
+
+  current_slice = 0;
+  split_slices_left = 0;
+  if (architecture.dst_selection_mode == DST_SEL_LOOKAHEAD ||
+      architecture.packing_policy == PACK_CRITICAL_FIRST ||
+      architecture.remote_gate_mode == REMOTE_ADAPTIVE ||
+      architecture.eviction_policy == EVICT_BELADY ||
+      architecture.eviction_policy == EVICT_NEIGHBOR)
+    lookahead.build(circuit);
+
+  eviction.reset();
+  eviction_comms.clear();
+  evicted_qubits.clear();
+  rebalancer.reset();
+  prefetched.clear();
+  prefetch_hits = 0;
+  prefetch_misspeculations = 0;
+  coalesced_messages = 0;
+  coalesced_packets = 0;
+  coalescing_saved_time = 0.0;
+  remote_gates_per_qubits.clear();
+  entanglement_swapping = (architecture.teleportation_type == TP_TYPE_SWAP);
+  shuttling = (architecture.teleportation_type == TP_TYPE_SHUTTLE);
+  swaps_per_path.clear();
+  swapping_time = 0.0;
+  hop_chain_time = 0.0;
+  cores.initCommPool(architecture.number_of_cores, architecture.comm_qubits);
+  comm_allocations = 0;
+  comm_overflows = 0;
+  comm_peak.assign(architecture.number_of_cores, 0);
+  comm_occupancy = 0.0;
+  comm_samples = 0;
+  mi_instructions.assign(architecture.memory_interfaces.getNumMIs(), 0);
+  mi_dispatch_volume.assign(architecture.memory_interfaces.getNumMIs(), 0);
+  mi_transfer_time.assign(architecture.memory_interfaces.getNumMIs(), 0.0);
+  icache.reset(architecture.number_of_cores, architecture.icache_capacity);
+  router.reset(architecture.coupling_graph, architecture.core_qubits,
+	       architecture.core_ltm_ports, cores);
+  swaps_per_core.assign(architecture.number_of_cores, 0);
+  noc.resetTrafficStats();
     
   cores.saveHistory(); // save the initial state of the cores
   
@@ -597,53 +1840,106 @@ Statistics Simulation::simulate(const Circuit& circuit, const Architecture& arch
 
       Statistics stats = simulate(parallel_gates, architecture, noc,
 				  parameters, mapping, cores);
+
+      if (architecture.prefetch_slices > 0)
+	prefetch(stats, parallel_gates, next(it_pgates), lcircuit.end(), architecture, noc,
+		 parameters, mapping, cores);
+
+      if (rebalancer.isEnabled(architecture))
+	rebalance(stats, parallel_gates,
+		  (next(it_pgates) == lcircuit.end()) ? ParallelGates() : *next(it_pgates),
+		  architecture, noc, parameters, mapping, cores);
             
       freeUnusedAncillas(it_pgates, lcircuit, mapping, cores);
 
       global_stats.updateStatistics(stats);
 
+      if (split_slices_left > 0)
+	split_slices_left--;
+      else
+	current_slice++;
     }
 
+  global_stats.prefetch_hits = prefetch_hits;
+  global_stats.prefetch_misspeculations = prefetch_misspeculations;
+  global_stats.coalesced_messages = coalesced_messages;
+  global_stats.coalesced_packets = coalesced_packets;
+  global_stats.coalescing_saved_time = coalescing_saved_time;
+  global_stats.remote_gates_per_qubits = remote_gates_per_qubits;
+  global_stats.swaps_per_core = swaps_per_core;
+  global_stats.swaps_per_path = swaps_per_path;
+  global_stats.swapping_time = swapping_time;
+  global_stats.hop_chain_time = hop_chain_time;
+  global_stats.comm_allocations = comm_allocations;
+  global_stats.comm_overflows = comm_overflows;
+  global_stats.comm_peak = comm_peak;
+  global_stats.comm_avg_relays = (comm_samples > 0) ?
+    comm_occupancy / (comm_samples * architecture.number_of_cores) : 0.0;
+  global_stats.mi_instructions = mi_instructions;
+  global_stats.mi_dispatch_volume = mi_dispatch_volume;
+  global_stats.mi_transfer_time = mi_transfer_time;
+  global_stats.noc_packets = noc.packets;
+  global_stats.noc_avg_packet_latency = noc.getAvgPacketLatency();
+  global_stats.noc_max_link_queue = noc.max_link_queue;
+  global_stats.hybrid_wired = noc.wired_traffic;
+  global_stats.hybrid_wireless = noc.wireless_traffic;
+
   // stop chrono and compute elapsed time
   simulation_runtime = stopChrono(chrono_start);
   
   return global_stats;
 }
 
+// ----------------------------------------------------------------------
+Statistics Simulation::simulateReference(const Circuit& circuit,
+					 const Architecture& reference_architecture,
+					 const NoC& noc, const Parameters& parameters,
+					 Mapping& mapping, Cores& cores)
+{
+  map<int,int> saved_qubit2core = mapping.qubit2core;
+  vector<Core> saved_cores = cores.cores;
+  list<vector<Core> > saved_history = cores.history;
+  int saved_ancilla_counter = cores.ancilla_counter;
+  vector<int> saved_comm_used = cores.comm_used;
+  set<int> saved_comm_ancillas = cores.comm_ancillas;
+  vector<int> saved_token_owner_map = noc.token_owner_map;
+
+  Statistics stats = simulate(circuit, reference_architecture, noc, parameters, mapping, cores);
+
+  mapping.qubit2core = saved_qubit2core;
+  cores.cores = saved_cores;
+  cores.history = saved_history;
+  cores.ancilla_counter = saved_ancilla_counter;
+  cores.comm_used = saved_comm_used;
+  cores.comm_ancillas = saved_comm_ancillas;
+  noc.token_owner_map = saved_token_owner_map;
+
+  return stats;
+}
+
+// ----------------------------------------------------------------------
+vector<int> Simulation::getCorePath(const int src_core, const int dst_core, const int packet_id,
+				    const NoC& noc)
+{
+  // Routers do not host qubits, thus they are skipped
+  vector<int> path;
+  for (int node : noc.getPath(src_core, dst_core, packet_id))
+    if (node < noc.number_of_cores)
+      path.push_back(node);
+
+  return path;
+}
+
 // ----------------------------------------------------------------------
 vector<int> Simulation::computeTPPathMesh(const int qubit_src, const int qubit_dst,
 					  const Architecture& architecture)
 {
-  vector<int> path;
-  
   int src_core = architecture.cores.mapping.qubit2CoreSafe(qubit_src);
   int dst_core = architecture.cores.mapping.qubit2CoreSafe(qubit_dst);
   
-  // XY routing
-  int xs = src_core % architecture.noc.mesh_x;
-  int ys = src_core / architecture.noc.mesh_x;
-  int xd = dst_core % architecture.noc.mesh_x;
-  int yd = dst_core / architecture.noc.mesh_x;
-
-  path.push_back(src_core);
-  int x = xs;
-  int y = ys;
-  while (x != xd || y != yd)
-    {
-      if (x < xd)
-	x++;
-      else if (x > xd)
-	x--;
-      else if (y < yd)
-	y++;
-      else if (y > yd)
-	y--;
-
-      int curr_core = y * architecture.noc.mesh_x + x;
-      path.push_back(curr_core);
-    }
-
-  return path;
+  // Same path of the classical messages of the teleportation
+  // (routing of the NoC)
+  return getCorePath(src_core, dst_core, qubit_src, architecture.noc);
 }
 
 // ----------------------------------------------------------------------
@@ -665,8 +1961,30 @@ vector<int> Simulation::computeTPPath(const int qubit_src, const int qubit_dst,
 int Simulation::allocateAncilla(const int core_id,
 				const Architecture& architecture){
   int ancilla;
+
+  // The relays are taken from the communication qubits of the
+  // core. If there are no free ones, they wait for one (see
+  // getCommPoolStallTime) or, with comm_overflow_to_data, they are
+  // taken from its data qubits
+  Cores& cores = architecture.cores;
+  bool full = (cores.comm_capacity > 0 && cores.comm_used[core_id] >= cores.comm_capacity);
+  if (cores.allocateCommQubit(core_id, ancilla, !architecture.comm_overflow_to_data))
+    {
+      comm_allocations++;
+      if (full)
+	comm_overflows++;
+      comm_peak[core_id] = max(comm_peak[core_id],
+			       min(cores.comm_used[core_id], cores.comm_capacity));
+      return ancilla;
+    }
+  if (architecture.comm_qubits > 0)
+    comm_overflows++;
+
+  if (architecture.eviction_policy != EVICT_NONE)
+    makeRoom(architecture, architecture.cores.mapping, architecture.cores, core_id, 1,
+	     protected_qubits);
   
-  if (!architecture.cores.allocateAncilla(core_id, architecture.qubits_per_core, ancilla))
+  if (!architecture.cores.allocateAncilla(core_id, architecture.getCoreCapacity(core_id), ancilla))
     {
       ostringstream oss;
       oss << "Cannot allocate ancilla on core " << core_id;
@@ -682,7 +2000,8 @@ int Simulation::allocateAncilla(const int core_id,
 // (ancilla qubits) are allocated, the mapping and core structures are
 // updated accordingly.
 ParallelGates Simulation::splitRemoteGate(const Gate& gate,
-					  const Architecture& architecture)
+					  const Architecture& architecture,
+					  map<int,int>& reserved)
 {
   assert(gate.second.size() == 2); // currently supported only two-input remote gates
 
@@ -695,8 +2014,22 @@ ParallelGates Simulation::splitRemoteGate(const Gate& gate,
   int qubit_src = *it;
   ++it;
   int qubit_dst = *it;
+
+  // The cost based selection may reverse the direction of the
+  // teleportation
+  if (architecture.dst_selection_mode == DST_SEL_COST)
+    {
+      const Mapping& mapping = architecture.cores.mapping;
+      double cost_dst = getDestinationCost(architecture, gate, mapping.qubit2CoreSafe(qubit_dst),
+					   mapping, architecture.cores, nullptr);
+      double cost_src = getDestinationCost(architecture, gate, mapping.qubit2CoreSafe(qubit_src),
+					   mapping, architecture.cores, nullptr);
+      if (cost_src < cost_dst)
+	swap(qubit_src, qubit_dst);
+    }
   
   vector<int> path = computeTPPath(qubit_src, qubit_dst, architecture);
+  reserved[path.back()]++;
 
   int next_qubit;
   for (size_t i=1; i<path.size(); i++)
@@ -706,7 +2039,10 @@ ParallelGates Simulation::splitRemoteGate(const Gate& gate,
       if (i == path.size()-1) // next_core is the last core in the path
 	next_qubit = qubit_dst;
       else
-	next_qubit = allocateAncilla(next_core, architecture);
+	{
+	  next_qubit = allocateAncilla(next_core, architecture);
+	  reserved[next_core]++; // qubit_src passing through
+	}
 
       Gate g(gate.first, {qubit_src, next_qubit});
       pg.push_back(g);
@@ -715,6 +2051,60 @@ ParallelGates Simulation::splitRemoteGate(const Gate& gate,
   return pg;
 }
 
+// ----------------------------------------------------------------------
+// The qubits of a gate with 3+ qubits are gathered in the median core
+// of the gate (see selectGatheringCore), each one through a chain of
+// hops as in splitRemoteGate. The chains of the qubits are
+// independent and run in parallel. The last hop of a chain is toward
+// a qubit of the gate in the gathering core or, if there are none, an
+// ancilla allocated there. The gate is then executed locally in the
+// slice following the longest chain.
+void Simulation::splitGatherRemoteGate(const Gate& gate, const Architecture& architecture,
+				       list<ParallelGates>& pgates_list, map<int,int>& reserved)
+{
+  const Mapping& mapping = architecture.cores.mapping;
+  int gathering_core = selectGatheringCore(architecture, gate, mapping, architecture.cores,
+					   &reserved);
+
+  int anchor = -1;
+  for (int qb : gate.second)
+    if (mapping.qubit2CoreSafe(qb) == gathering_core)
+      {
+	anchor = qb;
+	break;
+      }
+  if (anchor == -1)
+    anchor = allocateAncilla(gathering_core, architecture);
+
+  auto longest = pgates_list.end();
+  for (int qb : gate.second)
+    {
+      int src_core = mapping.qubit2CoreSafe(qb);
+      if (src_core == gathering_core)
+	continue;
+
+      vector<int> path = getCorePath(src_core, gathering_core, qb, architecture.noc);
+      reserved[gathering_core]++;
+      ParallelGates chain;
+      for (size_t i = 1; i < path.size(); i++)
+	{
+	  int next_qubit = anchor;
+	  if (i < path.size()-1)
+	    {
+	      next_qubit = allocateAncilla(path[i], architecture);
+	      reserved[path[i]]++; // qb passing through
+	    }
+	  chain.push_back(Gate(gate.first, {qb, next_qubit}));
+	}
+
+      pgates_list.push_back(chain);
+      if (longest == pgates_list.end() || chain.size() > longest->size())
+	longest = prev(pgates_list.end());
+    }
+
+  longest->push_back(gate);
+}
+
 // ----------------------------------------------------------------------
 // This method splits each remote gate into a list of remote gates
 // whose input qubits are located in two directly connected cores. As
@@ -727,9 +2117,22 @@ list<ParallelGates> Simulation::splitRemoteGates(const ParallelGates& rgates,
 						 const Architecture& architecture)
 {
   list<ParallelGates> pgates_list;
-  
+
+  // The path of a gate depends on the position of its qubits, thus
+  // the qubits of the gates already split cannot be evicted to make
+  // room for the ancillas
+  protected_qubits.clear();
+  // slots promised to the qubits moving to or passing through each
+  // core, which are not in the cores yet
+  map<int,int> reserved;
   for (const auto& gate : rgates)
-    pgates_list.push_back(splitRemoteGate(gate, architecture));
+    {
+      protected_qubits.insert(gate.second.begin(), gate.second.end());
+      if (gate.second.size() > 2)
+	splitGatherRemoteGate(gate, architecture, pgates_list, reserved);
+      else
+	pgates_list.push_back(splitRemoteGate(gate, architecture, reserved));
+    }
     
   return pgates_list;
 }
@@ -794,15 +2197,21 @@ ParallelGates Simulation::FixParallelGatesAndUpdateCircuit(list<ParallelGates>::
 {
   ParallelGates pgates = *it_pgates;
 
-  if (architecture.teleportation_type == TP_TYPE_A2A)
+  if (architecture.teleportation_type != TP_TYPE_MESH)
     return pgates; 
 
   ParallelGates lgates, rgates;
   splitLocalRemoteGates(pgates, architecture.cores.mapping, lgates, rgates);
+
+  // the slices inserted by a previous split only hold hop gates
+  if (split_slices_left == 0)
+    for (const auto& gate : rgates)
+      remote_gates_per_qubits[gate.second.size()]++;
   
   list<ParallelGates> pgates_list_par = splitRemoteGates(rgates, architecture);
   
   list<ParallelGates> pgates_list_seq = sequenceParallelGates(lgates, pgates_list_par);
+  split_slices_left += pgates_list_seq.size() - 1;
 
   ParallelGates pg = insertSequenceParallelGates(it_pgates, circuit, pgates_list_seq);
   
@@ -16,24 +16,191 @@
 #include "statistics.h"
 #include "noc.h"
 #include "parameters.h"
+#include "lookahead.h"
+#include "eviction.h"
+#include "rebalancer.h"
+#include "packing.h"
+#include "instruction_cache.h"
+#include "coupling.h"
 
 struct Simulation
 {
   string simulation_date_time;  
   double simulation_runtime;
 
+  // Index of the slice of the original circuit being simulated. When
+  // a slice is split into several slices (TP_TYPE_MESH),
+  // split_slices_left counts the split slices still to be simulated
+  int    current_slice;
+  int    split_slices_left;
+
+  LookaheadIndex lookahead;
+
+  // Evictions done in the current slice that have still to be
+  // charged in the statistics. While the remote gates of a slice are
+  // split (TP_TYPE_MESH), the qubits of the gates already split are
+  // in protected_qubits and cannot be evicted to make room for the
+  // ancillas.
+  EvictionManager        eviction;
+  set<int>               protected_qubits;
+  ParallelCommunications eviction_comms;
+  list<int>              evicted_qubits;
+
+  // LTM ports left idle by the last teleportation round of the
+  // current slice
+  vector<int> idle_ltm_ports;
+
+  Rebalancer rebalancer;
+
+  RemoteGatePacker packer;
+
+  InstructionCache icache;
+
+  // Placement of the qubits in the coupling graph of their core and
+  // SWAPs inserted so far in each core
+  IntraCoreRouter router;
+  vector<long>    swaps_per_core;
+
+  // Qubits teleported by prefetch and not used yet
+  set<int> prefetched;
+  int      prefetch_hits;
+  int      prefetch_misspeculations;
+
+  // Messages and packets of the classical communications coalesced so
+  // far, and the communication time saved by coalescing
+  long     coalesced_messages;
+  long     coalesced_packets;
+  double   coalescing_saved_time;
+
+  // Dispatch load of each memory interface: instructions, bits sent
+  // and time spent transferring them to the core of the MI
+  vector<long>   mi_instructions;
+  vector<long>   mi_dispatch_volume;
+  vector<double> mi_transfer_time;
+
+  // Remote gates of the circuit per number of qubits
+  map<int,long>  remote_gates_per_qubits;
+
+  // Entanglement swapping (TP_TYPE_SWAP): teleportations per number
+  // of swaps along their path, teleportation time of the rounds and
+  // estimated time of the same rounds as hop-by-hop chains
+  bool           entanglement_swapping;
+  bool           shuttling; // TP_TYPE_SHUTTLE
+  map<int,long>  swaps_per_path;
+  double         swapping_time;
+  double         hop_chain_time;
+
+  // Relay ancillas taken from the communication qubits, those taken
+  // from the data qubits because the pool was full, peak occupancy
+  // of each pool (relays and EPR halves) and relays held summed over
+  // the comm_samples slices (see Architecture::comm_qubits)
+  long            comm_allocations;
+  long            comm_overflows;
+  vector<int>     comm_peak;
+  double          comm_occupancy;
+  long            comm_samples;
+
+  Simulation() : simulation_runtime(0.0), current_slice(0), split_slices_left(0),
+		 prefetch_hits(0), prefetch_misspeculations(0), coalesced_messages(0),
+		 coalesced_packets(0), coalescing_saved_time(0.0), entanglement_swapping(false),
+		 shuttling(false), swapping_time(0.0), hop_chain_time(0.0), comm_allocations(0),
+		 comm_overflows(0), comm_occupancy(0.0), comm_samples(0) {}
+
   void display();
   
   bool isLocalGate(const Gate& gate, const Mapping& mapping);
   void splitLocalRemoteGates(const ParallelGates& pgates, const Mapping& mapping,
 			     ParallelGates& lgates, ParallelGates& rgates);
   Statistics localExecution(const ParallelGates& lgates,
-			    const Parameters& params);
+			    const Architecture& architecture,
+			    const Parameters& params,
+			    const Mapping& mapping, const Cores& cores);
+  // Latency of gates executed in parallel in their cores. With a
+  // coupling graph (see coupling.h), each gate is delayed by the SWAP
+  // chain bringing its qubits next to each other. The SWAPs and the
+  // time they add are charged to stats. The delays of a gate are
+  // those of the core executing it (see Architecture::core_overrides)
+  double getLocalGatesLatency(const ParallelGates& gates, const Architecture& architecture,
+			      const Parameters& params,
+			      const Mapping& mapping, const Cores& cores,
+			      Statistics& stats);
+  const map<string,double>& getGateDelays(const Architecture& architecture,
+					  const Parameters& params, const int core_id);
+  // All the destination selection policies share the same
+  // signature. available_ltm_ports, if not null, are the LTM ports
+  // still free in the current teleportation round.
   int selectDestinationCore(const Architecture& architecture,
-			    const Gate& gate, const Mapping& mapping, const Cores& cores);
+			    const Gate& gate, const Mapping& mapping, const Cores& cores,
+			    const vector<int>* available_ltm_ports = nullptr);
+  // Median core of the qubits of a gate with 3+ qubits: the core
+  // minimizing the hops traveled by the qubits gathered there. With
+  // TP_TYPE_MESH it is any core of the mesh with room for the
+  // incoming qubits, the anchor ancilla and the relays of the paths
+  // (see hasGatheringRoom), otherwise one of the cores hosting the
+  // qubits. Ties are broken in favor of the core hosting more
+  // qubits. If no core has room, the best core hosting the qubits is
+  // selected.
+  int selectGatheringCore(const Architecture& architecture, const Gate& gate,
+			  const Mapping& mapping, const Cores& cores,
+			  const map<int,int>* reserved = nullptr);
+  // True if the qubits of gate can be gathered in core_id: it takes
+  // the incoming qubits and, if it hosts none of them, the anchor; each
+  // relay core takes an ancilla and the qubit passing through it.
+  // reserved, if not null, are the slots already promised to the
+  // gates split before in the slice (see splitRemoteGates).
+  bool hasGatheringRoom(const Architecture& architecture, const Gate& gate, const int core_id,
+			const Mapping& mapping, const Cores& cores,
+			const map<int,int>* reserved);
+  int selectDestinationCoreLookahead(const Architecture& architecture,
+				     const Gate& gate, const Mapping& mapping,
+				     const Cores& cores);
+  int selectDestinationCoreCost(const Architecture& architecture,
+				const Gate& gate, const Mapping& mapping,
+				const Cores& cores, const vector<int>* available_ltm_ports);
+  // Cost of executing gate on core_id (DST_SEL_COST)
+  double getDestinationCost(const Architecture& architecture,
+			    const Gate& gate, const int core_id, const Mapping& mapping,
+			    const Cores& cores, const vector<int>* available_ltm_ports);
   void updateMappingAndCores(const Architecture& architecture,
 			     Mapping& mapping, Cores& cores,
 			     const Gate& gate, const int dst_core);
+  // Evicts qubits of core_id, but those in protected_set, until it
+  // has nslots free slots. Aborts if eviction is disabled
+  // (EVICT_NONE) or not possible.
+  void makeRoom(const Architecture& architecture, Mapping& mapping, Cores& cores,
+		const int core_id, const int nslots, const set<int>& protected_set);
+  // Adds the teleportations of the evictions of the current slice to
+  // stats. They are scheduled in rounds constrained by the LTM ports.
+  void chargeEvictions(Statistics& stats, const Architecture& architecture,
+		       const NoC& noc, const Parameters& params);
+  // Runs the background rebalancer after the slice pgates, whose
+  // statistics are in stats. Planned migrations are executed in the
+  // LTM ports left idle by the last round of the slice, but those of
+  // qubits used by pgates or next_pgates.
+  void rebalance(Statistics& stats, const ParallelGates& pgates,
+		 const ParallelGates& next_pgates,
+		 const Architecture& architecture, const NoC& noc,
+		 const Parameters& params, Mapping& mapping, Cores& cores);
+  // Teleports in advance the qubits of the remote gates of the next
+  // prefetch_slices slices (starting from it_next) using the LTM
+  // ports left idle by the slice pgates, whose statistics are in
+  // stats. The qubits of pgates are not moved
+  void prefetch(Statistics& stats, const ParallelGates& pgates,
+		list<ParallelGates>::const_iterator it_next,
+		list<ParallelGates>::const_iterator it_end,
+		const Architecture& architecture, const NoC& noc,
+		const Parameters& params, Mapping& mapping, Cores& cores);
+  // Must be called whenever a qubit is teleported: if it has been
+  // prefetched and not used yet, the prefetch was a mis-speculation
+  void cancelPrefetch(const int qb);
+  void checkPrefetchHits(const ParallelGates& pgates);
+  // Adds to stats communications done in background, in parallel
+  // with the slice. Their teleportation time is split into the
+  // hidden part and the part exceeding the execution time of the
+  // slice (exposed).
+  void addBackgroundCommunications(Statistics& stats, const ParallelCommunications& comms,
+				   const NoC& noc, const Parameters& params,
+				   double& hidden_time, double& exposed_time);
   void addParallelCommunications(ParallelCommunications& parallel_communications,
 				 const Gate& gate, const int dst_core,
 				 const Mapping& mapping, const int volume);
@@ -41,16 +208,78 @@ struct Simulation
   TeleportationTime getTeleportationTime(const ParallelCommunications& pcomms,
 					 const NoC& noc,
 					 const Parameters& params);
+  // Sets the EPR pair generation and distribution times of the
+  // teleportations in pcomms (see NoC::getEPRDistributionTime)
+  void setEPRTime(TeleportationTime& tt, const ParallelCommunications& pcomms,
+		  const NoC& noc, const Parameters& params, const bool swapping);
+  // Cores traversed from src_core to dst_core (both included)
+  vector<int> getCorePath(const int src_core, const int dst_core, const int packet_id,
+			  const NoC& noc);
+  // Estimated teleportation time of pcomms as chains of teleportations
+  // between neighbor cores, one round per hop (as with TP_TYPE_MESH,
+  // ancillas not included). The state of the NoC is not modified.
+  double getHopChainTime(const ParallelCommunications& pcomms,
+			 const NoC& noc, const Parameters& params);
+  // Communication time of the packets carrying the messages in pcomms
+  // (see NoC::packetize)
+  double getPacketizedCommunicationTime(const ParallelCommunications& pcomms,
+					const NoC& noc);
   void addTeleportationTime(TeleportationTime& total_ct,
 			    const TeleportationTime& ct);
+  // return_comms are the messages sent back by the telegates of the
+  // round after the gates
   void updateRemoteExecutionStats(Statistics& stats,
 				  const ParallelGates& pgates,
 				  const ParallelCommunications& pcomms,
-				  const NoC& noc,
-				  const Parameters& params);
+				  const ParallelCommunications& return_comms,
+				  const Architecture& architecture, const NoC& noc,
+				  const Parameters& params,
+				  const Mapping& mapping, const Cores& cores);
+  // Delay of a teleportation round of duration t_round waiting for
+  // free communication qubits. Each teleportation holds one in its
+  // source and destination cores, but a hop toward a relay that is
+  // itself a communication qubit, and a relay of the round waiting
+  // for a free one (see allocateAncilla). If a core needs more than
+  // those free, the teleportations are done in waves, each one
+  // releasing the communication qubits it used.
+  double getCommPoolStallTime(const ParallelGates& pgates, const ParallelCommunications& pcomms,
+			      const double t_round, const Mapping& mapping, const Cores& cores);
+  // Returns true if the remote gate has to be executed across the
+  // cores of its qubits (telegate) instead of teleporting them
+  // (teledata). With REMOTE_ADAPTIVE a two-qubit gate is a telegate if
+  // it is not more expensive than teledata (see getTelegateCost and
+  // getTeledataCost) with the LTM ports still available in the round.
+  bool useTelegate(const Architecture& architecture, const Parameters& params,
+		   const Gate& gate, const Mapping& mapping, const Cores& cores,
+		   const vector<int>& available_ltm_ports);
+  // Estimated time of a teleportation from src_core to dst_core with
+  // no other traffic: EPR pair, local operations and classical message
+  double getTeleportationEstimate(const Architecture& architecture, const Parameters& params,
+				  const int src_core, const int dst_core);
+  // A telegate takes a teleportation and the message back to the
+  // control core. A round is added if the two cores have no free LTM
+  // port.
+  double getTelegateCost(const Architecture& architecture, const Parameters& params,
+			 const Gate& gate, const Mapping& mapping,
+			 const vector<int>& available_ltm_ports);
+  // Teledata takes the teleportations of the qubits to the
+  // destination core in parallel, a round more if the LTM ports are
+  // not enough and one teleportation for each qubit to evict there.
+  // A moved qubit is expected to return to its core with the
+  // probability aff_src / (aff_src + aff_dst) of its lookahead
+  // affinities (see LookaheadIndex::affinity), which adds a
+  // teleportation back.
+  double getTeledataCost(const Architecture& architecture, const Parameters& params,
+			 const Gate& gate, const Mapping& mapping, const Cores& cores,
+			 const vector<int>& available_ltm_ports);
   void removeExecutedGates(const ParallelGates& scheduled_gates,
 			   ParallelGates& gates);
 
+  // Returns gates in the order they are visited by a teleportation
+  // round (see packing.h)
+  ParallelGates orderRemoteGates(const Architecture& architecture,
+				 const ParallelGates& gates,
+				 const Mapping& mapping, const Cores& cores);
   Statistics remoteExecution(const Architecture& architecture, const NoC& noc,
 			     const Parameters& parameters,
 			     const ParallelGates& rgates,
@@ -61,7 +290,8 @@ struct Simulation
   void fetchContribution(Statistics& stats,
 			 const ParallelGates& pgates,
 			 const Architecture& architecture,
-			 const Parameters& parameters);
+			 const Parameters& parameters,
+			 const Mapping& mapping);
   void decodeContribution(Statistics& stats,
 			  const ParallelGates& pgates,
 			  const Parameters& parameters);
@@ -70,10 +300,32 @@ struct Simulation
 			    const Architecture& architecture,
 			    const Parameters& parameters,
 			    const Mapping& mapping);
+  // Returns the gates of pgates whose bundle (the instructions of a
+  // core) is not in the instruction buffer of the core and updates
+  // the buffers and the lookup statistics
+  ParallelGates filterCachedInstructions(Statistics& stats,
+					 const ParallelGates& pgates,
+					 const Architecture& architecture,
+					 const Parameters& parameters,
+					 const Mapping& mapping);
+  // Dispatch time of pgates. Neither the NoC nor the statistics are
+  // modified.
+  double getDispatchTimeWithoutCache(const ParallelGates& pgates,
+				     const Architecture& architecture,
+				     const Parameters& parameters,
+				     const Mapping& mapping);
   ParallelCommunications makeDispatchCommunications(const ParallelGates& pgates,
 						    const Architecture& architecture,
 						    const Parameters& parameters,
 						    const Mapping& mapping);
+  // Core the instruction of gate is dispatched to: the core hosting
+  // the qubit in the second input of the gate (the first one for
+  // single-qubit gates)
+  int getDispatchCore(const Gate& gate, const Mapping& mapping);
+  ParallelCommunications makeDispatchMulticasts(const ParallelGates& pgates,
+						const Architecture& architecture,
+						const Parameters& parameters,
+						const Mapping& mapping);
 
   Statistics simulate(const ParallelGates& pgates, const Architecture& architecture,
 		      const NoC& noc, const Parameters& parameters,
@@ -82,6 +334,16 @@ struct Simulation
 		      const NoC& noc, const Parameters& parameters,
 		      Mapping& mapping, Cores& cores);
 
+  // Simulates the circuit on reference_architecture, a copy of the
+  // architecture with some options changed (e.g., the destination
+  // selection policy). Mapping, cores and NoC are restored
+  // afterwards, so the results can be used as a reference for the
+  // actual run.
+  Statistics simulateReference(const Circuit& circuit,
+			       const Architecture& reference_architecture,
+			       const NoC& noc, const Parameters& parameters,
+			       Mapping& mapping, Cores& cores);
+
   vector<int> computeTPPathMesh(const int qubit_src, const int qubit_dst,
 				const Architecture& architecture);
   vector<int> computeTPPath(const int qubit_src, const int qubit_dst,
@@ -89,7 +351,10 @@ struct Simulation
   int allocateAncilla(const int core_id,
 		      const Architecture& architecture);
   ParallelGates splitRemoteGate(const Gate& gate,
-				const Architecture& architecture);
+				const Architecture& architecture,
+				map<int,int>& reserved);
+  void splitGatherRemoteGate(const Gate& gate, const Architecture& architecture,
+			     list<ParallelGates>& pgates_list, map<int,int>& reserved);
   list<ParallelGates> splitRemoteGates(const ParallelGates& rgates,
 				       const Architecture& architecture);
   list<ParallelGates> sequenceParallelGates(const ParallelGates& lgates,
@@ -111,7 +376,7 @@ struct Simulation
   double getMaxGateLatency(const ParallelGates& lgates,
 			   const map<string,double>& gate_delays);
 
-  ParallelCommunications removeMI2Node0Communications(const ParallelCommunications& pcomms);
+  ParallelCommunications removeMI2NodeCommunications(const ParallelCommunications& pcomms);
 
 };
 
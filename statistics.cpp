@@ -30,6 +30,44 @@ Statistics::Statistics()
   fetch_time = 0.0;
   decode_time = 0.0;
   dispatch_time = 0.0;
+  evictions = 0;
+  eviction_time = 0.0;
+  rebalance_migrations = 0;
+  rebalance_hidden_time = 0.0;
+  rebalance_exposed_time = 0.0;
+  prefetches = 0;
+  prefetch_hits = 0;
+  prefetch_misspeculations = 0;
+  prefetch_hidden_time = 0.0;
+  prefetch_exposed_time = 0.0;
+  remote_gates = 0;
+  telegates = 0;
+  teledata_time = 0.0;
+  telegate_time = 0.0;
+  local_swaps = 0;
+  comm_allocations = 0;
+  comm_overflows = 0;
+  comm_avg_relays = 0.0;
+  comm_stalled_rounds = 0;
+  local_swap_time = 0.0;
+  coalesced_messages = 0;
+  coalesced_packets = 0;
+  coalescing_saved_time = 0.0;
+  swapping_time = 0.0;
+  hop_chain_time = 0.0;
+  icache_lookups = 0;
+  icache_hits = 0;
+  icache_fetch_saved_time = 0.0;
+  icache_dispatch_saved_time = 0.0;
+  noc_packets = 0;
+  noc_avg_packet_latency = 0.0;
+  noc_max_link_queue = 0;
+  remote_rounds = 0;
+  remote_slices = 0;
+  max_remote_rounds = 0;
+  reference_teleportations = -1;
+  reference_dst_selection_mode = -1;
+  reference_remote_gate_latency = -1.0;
 }
 
 Statistics::Statistics(const int ncores) : Statistics()
@@ -40,9 +78,25 @@ Statistics::Statistics(const int ncores) : Statistics()
 
 double Statistics::getExecutionTime() const
 {
-  return (computation_time + teleportation_time.getTotalTeleportationTime() + fetch_time + decode_time + dispatch_time);
+  return (computation_time + teleportation_time.getTotalTeleportationTime() + fetch_time + decode_time + dispatch_time +
+	  rebalance_exposed_time + prefetch_exposed_time);
 }
 
+double Statistics::getRemoteGateLatency() const
+{
+  return (remote_gates == 0) ? 0.0 : teleportation_time.getTotalTeleportationTime() / remote_gates;
+}
+
+
+int Statistics::getTotalTeleportations() const
+{
+  int total = 0;
+
+  for (const auto& pair : teleportations_per_qubit)
+    total += pair.second;
+
+  return total;
+}
 
 // return core idx where qb is located. -1 if not found
 int Statistics::qbitToCore(const int qb, const vector<Core> cores)
@@ -77,6 +131,12 @@ void Statistics::displayOperationsPerQubit()
 {
   cout << "{";
 
+  if (operations_per_qubit.empty())
+    {
+      cout << "}" << endl;
+      return;
+    }
+
   auto it = operations_per_qubit.begin();
   auto last = prev(operations_per_qubit.end());
   for (; it != operations_per_qubit.end(); ++it) {
@@ -91,6 +151,12 @@ void Statistics::displayTeleportationsPerQubit()
 {
   cout << "{";
 
+  if (teleportations_per_qubit.empty())
+    {
+      cout << "}" << endl;
+      return;
+    }
+
   auto it = teleportations_per_qubit.begin();
   auto last = prev(teleportations_per_qubit.end());
   for (; it != teleportations_per_qubit.end(); ++it) {
@@ -109,7 +175,160 @@ void Statistics::display(const Cores& cores, const Architecture& arch,
        << IND << "executed_gates: " << executed_gates << endl
        << IND << "total_intercore_communications: " << total_intercore_comms << endl
        << IND << "intercore_traffic_volume: " << intercore_volume << " # bits" << endl
-       << IND << "throughput:" << endl
+       << IND << "total_teleportations: " << getTotalTeleportations() << endl;
+
+  if (reference_teleportations >= 0)
+    {
+      int tps = getTotalTeleportations();
+      cout << IND << "reference_dst_selection:" << endl
+	   << IND << IND << "dst_selection_mode: " << reference_dst_selection_mode << endl
+	   << IND << IND << "total_teleportations: " << reference_teleportations << endl
+	   << IND << IND << "teleportation_reduction: "
+	   << ((reference_teleportations > 0) ?
+	       100.0 * (reference_teleportations - tps) / reference_teleportations : 0.0)
+	   << " # %" << endl;
+    }
+
+  cout << IND << "teleportation_rounds:" << endl
+       << IND << IND << "total: " << remote_rounds << endl
+       << IND << IND << "avg_per_slice: "
+       << ((remote_slices > 0) ? (double)remote_rounds / remote_slices : 0.0)
+       << " # slices with remote gates" << endl
+       << IND << IND << "max_per_slice: " << max_remote_rounds << endl;
+
+  cout << IND << "remote_gates_per_qubits: {";
+  for (auto it = remote_gates_per_qubits.begin(); it != remote_gates_per_qubits.end(); ++it)
+    cout << (it == remote_gates_per_qubits.begin() ? "" : ", ") << it->first << ": " << it->second;
+  cout << "} # qubits: gates" << endl;
+
+  if (arch.eviction_policy != EVICT_NONE)
+    cout << IND << "evictions:" << endl
+	 << IND << IND << "count: " << evictions << endl
+	 << IND << IND << "time: " << eviction_time << " # sec" << endl;
+
+  if (arch.prefetch_slices > 0)
+    cout << IND << "prefetch:" << endl
+	 << IND << IND << "teleportations: " << prefetches << endl
+	 << IND << IND << "hits: " << prefetch_hits << endl
+	 << IND << IND << "misspeculations: " << prefetch_misspeculations << endl
+	 << IND << IND << "hidden_time: " << prefetch_hidden_time << " # sec" << endl
+	 << IND << IND << "exposed_time: " << prefetch_exposed_time << " # sec" << endl;
+
+  if (arch.rebalance_interval > 0 || arch.rebalance_threshold > 0.0)
+    {
+      double latency = getRemoteGateLatency();
+      cout << IND << "rebalancing:" << endl
+	   << IND << IND << "migrations: " << rebalance_migrations << endl
+	   << IND << IND << "hidden_time: " << rebalance_hidden_time << " # sec" << endl
+	   << IND << IND << "exposed_time: " << rebalance_exposed_time << " # sec" << endl
+	   << IND << IND << "remote_gate_latency: " << latency << " # sec" << endl;
+      if (reference_remote_gate_latency >= 0.0)
+	cout << IND << IND << "reference_remote_gate_latency: " << reference_remote_gate_latency
+	     << " # sec (without rebalancing)" << endl
+	     << IND << IND << "latency_reduction: "
+	     << ((reference_remote_gate_latency > 0.0) ?
+		 100.0 * (reference_remote_gate_latency - latency) / reference_remote_gate_latency : 0.0)
+	     << " # %" << endl;
+    }
+
+  if (arch.noc.coalescing)
+    cout << IND << "coalescing:" << endl
+	 << IND << IND << "messages: " << coalesced_messages << endl
+	 << IND << IND << "packets: " << coalesced_packets << endl
+	 << IND << IND << "saved_time: " << coalescing_saved_time << " # sec" << endl;
+
+  if (arch.remote_gate_mode != REMOTE_TELEDATA)
+    cout << IND << "remote_gate_execution:" << endl
+	 << IND << IND << "teledata: {gates: " << remote_gates - telegates
+	 << ", time: " << teledata_time << "} # sec" << endl
+	 << IND << IND << "telegate: {gates: " << telegates
+	 << ", time: " << telegate_time << "} # sec" << endl;
+
+  if (arch.coupling_graph != COUPLING_FULL)
+    {
+      cout << IND << "intra_core_routing:" << endl
+	   << IND << IND << "swaps: " << local_swaps << endl
+	   << IND << IND << "swap_time: " << local_swap_time << " # sec added to the gate latencies" << endl
+	   << IND << IND << "swaps_per_core: [";
+      for (unsigned int c = 0; c < swaps_per_core.size(); c++)
+	cout << (c > 0 ? ", " : "") << swaps_per_core[c];
+      cout << "]" << endl;
+    }
+
+  if (arch.comm_qubits > 0)
+    {
+      cout << IND << "comm_qubits:" << endl
+	   << IND << IND << "allocations: " << comm_allocations << " # relays" << endl
+	   << IND << IND << "overflows: " << comm_overflows
+	   << (arch.comm_overflow_to_data ? " # relays in the data qubits" : " # relays waiting for a free one") << endl
+	   << IND << IND << "peak_occupancy: [";
+      for (unsigned int c = 0; c < comm_peak.size(); c++)
+	cout << (c > 0 ? ", " : "") << comm_peak[c];
+      cout << "]" << endl
+	   << IND << IND << "avg_relays: " << comm_avg_relays << " # held per core" << endl
+	   << IND << IND << "stalled_rounds: " << comm_stalled_rounds << endl
+	   << IND << IND << "stall_time: " << teleportation_time.t_pool << " # sec" << endl;
+    }
+
+  if (arch.teleportation_type == TP_TYPE_SWAP)
+    {
+      long paths = 0, swaps = 0;
+      cout << IND << "entanglement_swapping:" << endl
+	   << IND << IND << "swaps_per_path: {";
+      for (auto it = swaps_per_path.begin(); it != swaps_per_path.end(); ++it)
+	{
+	  cout << (it == swaps_per_path.begin() ? "" : ", ") << it->first << ": " << it->second;
+	  paths += it->second;
+	  swaps += it->first * it->second;
+	}
+      cout << "} # swaps: teleportations" << endl
+	   << IND << IND << "swaps: " << swaps << endl
+	   << IND << IND << "avg_swaps_per_path: " << ((paths > 0) ? (double)swaps / paths : 0.0) << endl
+	   << IND << IND << "teleportation_time: " << swapping_time << " # sec" << endl
+	   << IND << IND << "hop_chain_time: " << hop_chain_time
+	   << " # sec (teleportation_type 1, ancillas not included)" << endl
+	   << IND << IND << "speedup: "
+	   << ((swapping_time > 0.0) ? hop_chain_time / swapping_time : 0.0) << endl;
+    }
+
+  if (arch.icache_capacity > 0)
+    cout << IND << "instruction_cache:" << endl
+	 << IND << IND << "lookups: " << icache_lookups << " # bundles of the cores" << endl
+	 << IND << IND << "hits: " << icache_hits << endl
+	 << IND << IND << "hit_rate: "
+	 << ((icache_lookups > 0) ? 100.0 * icache_hits / icache_lookups : 0.0) << " # %" << endl
+	 << IND << IND << "fetch_saved_time: " << icache_fetch_saved_time << " # sec" << endl
+	 << IND << IND << "dispatch_saved_time: " << icache_dispatch_saved_time << " # sec" << endl;
+
+  const MemoryInterfaces& mis = arch.memory_interfaces;
+  cout << IND << "memory_interfaces:" << endl;
+  for (int i = 0; i < (int)mi_instructions.size(); i++)
+    {
+      int served = count(mis.mi_of_core.begin(), mis.mi_of_core.end(), i);
+      cout << IND << IND << "'mi " << i << "': {core: " << mis.cores[i]
+	   << ", cores_served: " << served
+	   << ", instructions: " << mi_instructions[i]
+	   << ", volume: " << mi_dispatch_volume[i]
+	   << ", transfer_time: " << mi_transfer_time[i] << "} # bits, sec" << endl;
+    }
+
+  if (!arch.noc.winoc && arch.noc.hybrid_mode != HYBRID_OFF)
+    cout << IND << "hybrid_traffic:" << endl
+	 << IND << IND << "wired: {messages: " << hybrid_wired.messages
+	 << ", volume: " << hybrid_wired.volume
+	 << ", time: " << hybrid_wired.time << "} # bits, sec" << endl
+	 << IND << IND << "wireless: {messages: " << hybrid_wireless.messages
+	 << ", volume: " << hybrid_wireless.volume
+	 << ", time: " << hybrid_wireless.time << "} # bits, sec" << endl;
+
+  if (!arch.noc.winoc)
+    cout << IND << "noc_traffic:" << endl
+	 << IND << IND << "routing_algorithm: " << arch.noc.routing_algorithm << endl
+	 << IND << IND << "packets: " << noc_packets << endl
+	 << IND << IND << "avg_packet_latency: " << noc_avg_packet_latency << " # cycles" << endl
+	 << IND << IND << "max_link_queue: " << noc_max_link_queue << " # packets" << endl;
+
+  cout << IND << "throughput:" << endl
        << IND << IND << "avg: " << avg_throughput/1.0e6 << " # Mbps" << endl
        << IND << IND << "peak: " << max_throughput/1.0e6 << " # Mbps" << endl;
 
@@ -153,14 +372,42 @@ void Statistics::updateStatistics(const Statistics& stats)
   
   teleportation_time.t_epr += stats.teleportation_time.t_epr;
   teleportation_time.t_dist += stats.teleportation_time.t_dist;
+  teleportation_time.t_swap += stats.teleportation_time.t_swap;
   teleportation_time.t_pre += stats.teleportation_time.t_pre;
   teleportation_time.t_clas += stats.teleportation_time.t_clas;
   teleportation_time.t_post += stats.teleportation_time.t_post;
+  teleportation_time.t_shuttle += stats.teleportation_time.t_shuttle;
+  teleportation_time.t_pool += stats.teleportation_time.t_pool;
 
   fetch_time += stats.fetch_time;
   decode_time += stats.decode_time;
   dispatch_time += stats.dispatch_time;
 
+  evictions += stats.evictions;
+  eviction_time += stats.eviction_time;
+  rebalance_migrations += stats.rebalance_migrations;
+  rebalance_hidden_time += stats.rebalance_hidden_time;
+  rebalance_exposed_time += stats.rebalance_exposed_time;
+  prefetches += stats.prefetches;
+  prefetch_hits += stats.prefetch_hits;
+  prefetch_misspeculations += stats.prefetch_misspeculations;
+  prefetch_hidden_time += stats.prefetch_hidden_time;
+  prefetch_exposed_time += stats.prefetch_exposed_time;
+  remote_gates += stats.remote_gates;
+  telegates += stats.telegates;
+  teledata_time += stats.teledata_time;
+  telegate_time += stats.telegate_time;
+  local_swaps += stats.local_swaps;
+  comm_stalled_rounds += stats.comm_stalled_rounds;
+  local_swap_time += stats.local_swap_time;
+  icache_lookups += stats.icache_lookups;
+  icache_hits += stats.icache_hits;
+  icache_fetch_saved_time += stats.icache_fetch_saved_time;
+  icache_dispatch_saved_time += stats.icache_dispatch_saved_time;
+  remote_rounds += stats.remote_rounds;
+  remote_slices += stats.remote_slices;
+  max_remote_rounds = max(max_remote_rounds, stats.max_remote_rounds);
+
   double th = stats.intercore_volume / stats.getExecutionTime();
     
   // update throughput stats
@@ -198,9 +445,9 @@ void Statistics::getCoresStats(const vector<Core>& cores, const Architecture& ar
   max_u = numeric_limits<double>::min();
   double sum_u = 0.0;
   
-  for (const auto& core : cores)
+  for (unsigned int index = 0; index < cores.size(); index++)
     {
-      double utilization = (double)core.size() / arch.qubits_per_core;
+      double utilization = (double)cores[index].size() / arch.getCoreCapacity(index);
       sum_u += utilization;
       if (utilization < min_u) min_u = utilization;
       if (utilization > max_u) max_u = utilization;      
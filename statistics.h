@@ -35,6 +35,108 @@ struct Statistics
   vector<vector<int>> intercore_comms; // row is source, col is target
   map<int,int> teleportations_per_qubit;
   map<int,int> operations_per_qubit;
+
+  // Migrations of qubits out of full cores (see eviction.h). Their
+  // teleportation time is also accounted in teleportation_time
+  int    evictions;
+  double eviction_time;
+
+  // Migrations of the background rebalancer (see rebalancer.h). The
+  // part of their teleportation time not overlapped with the
+  // execution of the slices is exposed and adds to the execution
+  // time
+  int    rebalance_migrations;
+  double rebalance_hidden_time;
+  double rebalance_exposed_time;
+
+  // Teleportations done in advance by prefetch. Hits are prefetched
+  // qubits used where they have been moved, mis-speculations are
+  // prefetched qubits moved again before their use
+  int    prefetches;
+  int    prefetch_hits;
+  int    prefetch_misspeculations;
+  double prefetch_hidden_time;
+  double prefetch_exposed_time;
+
+  int    remote_gates; // gates executed through teleportation
+  // Remote gates of the circuit per number of qubits (with
+  // TP_TYPE_MESH before their split in hops)
+  map<int,long> remote_gates_per_qubits;
+
+  // Remote gates executed across the cores (see
+  // Architecture::remote_gate_mode), the others are teledata. The
+  // teleportation time of a round is shared by its gates, but the
+  // return messages that are charged to the telegates.
+  int    telegates;
+  double teledata_time;
+  double telegate_time;
+
+  // SWAPs inserted in the cores to bring the qubits of the gates
+  // next to each other (see Architecture::coupling_graph), latency
+  // they add to the gates and SWAPs per core
+  long   local_swaps;
+  double local_swap_time;
+  vector<long> swaps_per_core;
+
+  // Relay ancillas taken from the communication qubits and from the
+  // data qubits (pool full), peak communication qubits in use and
+  // average relays held per core, and teleportation rounds delayed by
+  // the pool
+  // (see Simulation::getCommPoolStallTime)
+  long   comm_allocations;
+  long   comm_overflows;
+  vector<int> comm_peak;
+  double comm_avg_relays;
+  int    comm_stalled_rounds;
+
+  // Classical messages merged into packets (NoC::coalescing) and the
+  // communication time saved
+  long   coalesced_messages;
+  long   coalesced_packets;
+  double coalescing_saved_time;
+
+  // Teleportations per number of entanglement swaps along their path
+  // (TP_TYPE_SWAP), teleportation time of their rounds and estimated
+  // time of the same rounds as hop-by-hop chains (see
+  // Simulation::getHopChainTime)
+  map<int,long> swaps_per_path;
+  double swapping_time;
+  double hop_chain_time;
+
+  // Dispatch load of each memory interface (see
+  // Simulation::dispatchContribution)
+  vector<long>   mi_instructions;
+  vector<long>   mi_dispatch_volume; // bits
+  vector<double> mi_transfer_time;
+
+  // Bundles of the cores looked up in the instruction buffers (see
+  // instruction_cache.h), hits and time saved by the hits
+  long   icache_lookups;
+  long   icache_hits;
+  double icache_fetch_saved_time;
+  double icache_dispatch_saved_time;
+
+  // Traffic of the hybrid NoC per medium (see NoC::hybrid_mode)
+  MediumTraffic hybrid_wired;
+  MediumTraffic hybrid_wireless;
+
+  // Packets routed in the wired NoC (see NoC::routing_algorithm)
+  long   noc_packets;
+  double noc_avg_packet_latency; // in clock cycles
+  int    noc_max_link_queue;
+
+  // Teleportation rounds needed by the remote gates (see packing.h),
+  // slices with remote gates and max number of rounds of a slice
+  int    remote_rounds;
+  int    remote_slices;
+  int    max_remote_rounds;
+
+  // Number of teleportations obtained with a reference destination
+  // selection policy (-1 if no reference has been simulated)
+  int reference_teleportations;
+  int reference_dst_selection_mode;
+  // Remote gate latency without rebalancing (-1 if not simulated)
+  double reference_remote_gate_latency;
   
   Statistics();
   Statistics(const int ncores);
@@ -45,6 +147,11 @@ struct Statistics
 	       const Parameters& params);
 
   double getExecutionTime() const;
+
+  int getTotalTeleportations() const;
+
+  // Average teleportation time per remote gate
+  double getRemoteGateLatency() const;
   
   void getCoresStats(const vector<Core>& cores, const Architecture& arch,
 		     double& avg_u, double& min_u, double& max_u);
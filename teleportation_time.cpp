@@ -26,6 +26,9 @@ void TeleportationTime::display(const string& prefix) const
   cout << prefix << prefix << "epr_pair_distribution_time: " << t_dist << " # sec "
        << "(" << 100*t_dist/total_time << "%)" << endl;
   
+  cout << prefix << prefix << "entanglement_swapping_time: " << t_swap << " # sec "
+       << "(" << 100*t_swap/total_time << "%)" << endl;
+  
   cout << prefix << prefix << "pre_processing_time: " << t_pre << " # sec "
        << "(" << 100*t_pre/total_time << "%)" << endl;
   
@@ -35,6 +38,12 @@ void TeleportationTime::display(const string& prefix) const
   cout << prefix << prefix << "post_processing_time: " << t_post << " # sec "
        << "(" << 100*t_post/total_time << "%)" << endl;
   
+  cout << prefix << prefix << "shuttling_time: " << t_shuttle << " # sec "
+       << "(" << 100*t_shuttle/total_time << "%)" << endl;
+  
+  cout << prefix << prefix << "comm_pool_stall_time: " << t_pool << " # sec "
+       << "(" << 100*t_pool/total_time << "%)" << endl;
+  
   /*
   cout << prefix << "teleportation_time_components:" << endl
        << prefix << prefix << "epr_pair_generation_time:" << endl
@@ -57,5 +66,5 @@ void TeleportationTime::display(const string& prefix) const
 
 double TeleportationTime::getTotalTeleportationTime() const
 {
-  return t_epr + t_dist + t_pre + t_clas + t_post;
+  return t_epr + t_dist + t_swap + t_pre + t_clas + t_post + t_shuttle + t_pool;
 }
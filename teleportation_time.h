@@ -16,11 +16,14 @@ struct TeleportationTime
 {
   double t_epr; // EPR pair generation time
   double t_dist; // EPR pair distribution time
+  double t_swap; // Entanglement swapping time (TP_TYPE_SWAP)
   double t_pre; // Pre-processing time
   double t_clas; // Classical transfer time
   double t_post; // Post-processing time
+  double t_shuttle; // Shuttling time (TP_TYPE_SHUTTLE)
+  double t_pool; // Wait for free communication qubits (Architecture::comm_qubits)
 
-  TeleportationTime() : t_epr(0.0), t_dist(0.0), t_pre(0.0), t_clas(0.0), t_post(0.0) {}
+  TeleportationTime() : t_epr(0.0), t_dist(0.0), t_swap(0.0), t_pre(0.0), t_clas(0.0), t_post(0.0), t_shuttle(0.0), t_pool(0.0) {}
 
   void display(const string& prefix = "") const;
 
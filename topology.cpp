@@ -0,0 +1,459 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: topology.cpp
+// Description: Implementation of the interconnection topologies of the cores
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <set>
+#include "utils.h"
+#include "topology.h"
+
+// ----------------------------------------------------------------------
+void Topology::clear(const int ncores, const int nnodes)
+{
+  number_of_cores = ncores;
+  number_of_nodes = nnodes;
+  adjacency.assign(nnodes, vector<int>());
+  links.clear();
+  next_hop.clear();
+  hops.clear();
+  torus_x = torus_y = 0;
+  routes = ROUTES_SHORTEST;
+  vc_classes = 1;
+  vc_class.clear();
+}
+
+// ----------------------------------------------------------------------
+void Topology::addLink(const int a, const int b, const int width, const int latency)
+{
+  assert(a >= 0 && a < number_of_nodes && b >= 0 && b < number_of_nodes);
+
+  // e.g., the wrap-around link of a 2-node ring
+  if (a == b || links.find(make_pair(a, b)) != links.end())
+    return;
+
+  adjacency[a].push_back(b);
+  adjacency[b].push_back(a);
+  links[make_pair(a, b)] = {width, latency};
+  links[make_pair(b, a)] = {width, latency};
+}
+
+// ----------------------------------------------------------------------
+const Link* Topology::getLink(const int a, const int b) const
+{
+  auto it = links.find(make_pair(a, b));
+
+  return (it == links.end()) ? nullptr : &it->second;
+}
+
+// ----------------------------------------------------------------------
+void Topology::buildMesh(const int mesh_x, const int mesh_y, const int width, const bool wrap)
+{
+  clear(mesh_x * mesh_y, mesh_x * mesh_y);
+  if (wrap)
+    {
+      torus_x = mesh_x;
+      torus_y = mesh_y;
+    }
+
+  for (int y = 0; y < mesh_y; y++)
+    for (int x = 0; x < mesh_x; x++)
+      {
+	int id = y * mesh_x + x;
+	if (x + 1 < mesh_x || (wrap && mesh_x > 1))
+	  addLink(id, y * mesh_x + (x + 1) % mesh_x, width, 1);
+	if (y + 1 < mesh_y || (wrap && mesh_y > 1))
+	  addLink(id, ((y + 1) % mesh_y) * mesh_x + x, width, 1);
+      }
+}
+
+// ----------------------------------------------------------------------
+void Topology::buildRing(const int ncores, const int width)
+{
+  clear(ncores, ncores);
+  torus_x = ncores;
+  torus_y = 1;
+
+  for (int c = 0; c < ncores; c++)
+    addLink(c, (c + 1) % ncores, width, 1);
+}
+
+// ----------------------------------------------------------------------
+void Topology::buildConcentratedMesh(const int mesh_x, const int mesh_y,
+				     const int concentration, const int width)
+{
+  int nrouters = mesh_x * mesh_y;
+  int ncores = nrouters * concentration;
+  clear(ncores, ncores + nrouters);
+
+  for (int c = 0; c < ncores; c++)
+    addLink(c, ncores + c / concentration, width, 1);
+
+  for (int y = 0; y < mesh_y; y++)
+    for (int x = 0; x < mesh_x; x++)
+      {
+	int id = ncores + y * mesh_x + x;
+	if (x + 1 < mesh_x)
+	  addLink(id, id + 1, width, 1);
+	if (y + 1 < mesh_y)
+	  addLink(id, id + mesh_x, width, 1);
+      }
+}
+
+// ----------------------------------------------------------------------
+void Topology::buildCluster(const int nclusters, const int concentration, const int width,
+			    const int global_latency)
+{
+  int ncores = nclusters * concentration;
+  clear(ncores, ncores);
+
+  for (int k = 0; k < nclusters; k++)
+    {
+      int first = k * concentration;
+      for (int a = first; a < first + concentration; a++)
+	for (int b = a + 1; b < first + concentration; b++)
+	  addLink(a, b, width, 1);
+
+      for (int h = k + 1; h < nclusters; h++)
+	addLink(first, h * concentration, width, global_latency);
+    }
+}
+
+// ----------------------------------------------------------------------
+bool Topology::readFromFile(const string& file_name, const int default_width)
+{
+  YAML::Node config;
+  if (!loadYAMLFile(file_name, config))
+    return false;
+
+  int ncores, nrouters;
+  bool result = true;
+  result &= getOrFail<int>(config, "number_of_cores", file_name, ncores);
+  result &= getOrDefault<int>(config, "number_of_routers", file_name, nrouters, 0);
+  vector<vector<int> > edges;
+  result &= getOrFail<vector<vector<int> > >(config, "links", file_name, edges);
+  if (!result)
+    return false;
+
+  clear(ncores, ncores + nrouters);
+  for (const auto& e : edges)
+    {
+      if ((e.size() != 2 && e.size() != 4) ||
+	  e[0] < 0 || e[0] >= number_of_nodes || e[1] < 0 || e[1] >= number_of_nodes)
+	{
+	  cerr << "Error: invalid link in " << file_name << endl;
+	  return false;
+	}
+
+      if (e.size() == 4 && (e[2] <= 0 || e[3] <= 0))
+	{
+	  cerr << "Error: link width and latency must be positive in " << file_name << endl;
+	  return false;
+	}
+
+      addLink(e[0], e[1], (e.size() == 4) ? e[2] : default_width, (e.size() == 4) ? e[3] : 1);
+    }
+
+  return true;
+}
+
+// ----------------------------------------------------------------------
+bool Topology::computeRoutingTables(const bool deadlock_free)
+{
+  if (torus_x > 0)
+    {
+      computeDimensionOrderTables();
+      return true;
+    }
+
+  if (!computeShortestPathTables())
+    return false;
+
+  if (deadlock_free && hasCyclicDependencies())
+    computeUpDownTables();
+
+  return true;
+}
+
+// ----------------------------------------------------------------------
+void Topology::computeDimensionOrderTables()
+{
+  routes = ROUTES_DIMENSION_ORDER;
+  vc_classes = 2;
+  next_hop.assign(number_of_nodes, vector<int>(number_of_cores, -1));
+  hops.assign(number_of_nodes, vector<int>(number_of_cores, 0));
+  vc_class.assign(number_of_nodes, vector<int>(number_of_cores, 0));
+
+  // Step from a to b in a ring of n nodes: direction, hops and
+  // whether the wrap-around link is crossed
+  auto step = [](const int a, const int b, const int n, int& dir, int& nhops, bool& crosses) {
+    int forward = (b - a + n) % n, backward = (a - b + n) % n;
+    dir = (forward <= backward) ? 1 : -1;
+    nhops = min(forward, backward);
+    crosses = (dir > 0) ? (b < a) : (b > a);
+  };
+
+  for (int dst = 0; dst < number_of_cores; dst++)
+    for (int n = 0; n < number_of_nodes; n++)
+      {
+	int x = n % torus_x, y = n / torus_x;
+	int dx = dst % torus_x, dy = dst / torus_x;
+	int dir_x, dir_y, hops_x, hops_y;
+	bool crosses_x, crosses_y;
+	step(x, dx, torus_x, dir_x, hops_x, crosses_x);
+	step(y, dy, torus_y, dir_y, hops_y, crosses_y);
+
+	hops[n][dst] = hops_x + hops_y;
+	if (n == dst)
+	  next_hop[n][dst] = dst;
+	else if (x != dx)
+	  {
+	    next_hop[n][dst] = y * torus_x + (x + dir_x + torus_x) % torus_x;
+	    vc_class[n][dst] = crosses_x ? 0 : 1;
+	  }
+	else
+	  {
+	    next_hop[n][dst] = ((y + dir_y + torus_y) % torus_y) * torus_x + x;
+	    vc_class[n][dst] = crosses_y ? 0 : 1;
+	  }
+      }
+}
+
+// ----------------------------------------------------------------------
+bool Topology::computeShortestPathTables()
+{
+  const long inf = numeric_limits<long>::max();
+
+  routes = ROUTES_SHORTEST;
+  vc_classes = 1;
+  next_hop.assign(number_of_nodes, vector<int>(number_of_cores, -1));
+  hops.assign(number_of_nodes, vector<int>(number_of_cores, 0));
+  vc_class.assign(number_of_nodes, vector<int>(number_of_cores, 0));
+
+  for (int dst = 0; dst < number_of_cores; dst++)
+    {
+      // Dijkstra from dst (links are bidirectional). The cost is the
+      // sum of the latencies, ties are broken by hops.
+      vector<long> cost(number_of_nodes, inf);
+      vector<int> nhops(number_of_nodes, 0);
+      priority_queue<pair<long,int>, vector<pair<long,int> >, greater<pair<long,int> > > pq;
+      cost[dst] = 0;
+      pq.push(make_pair(0, dst));
+      while (!pq.empty())
+	{
+	  long c = pq.top().first;
+	  int n = pq.top().second;
+	  pq.pop();
+	  if (c > cost[n])
+	    continue;
+
+	  for (int m : adjacency[n])
+	    {
+	      long cm = c + links.at(make_pair(m, n)).latency;
+	      if (cm < cost[m] || (cm == cost[m] && nhops[n] + 1 < nhops[m]))
+		{
+		  cost[m] = cm;
+		  nhops[m] = nhops[n] + 1;
+		  pq.push(make_pair(cm, m));
+		}
+	    }
+	}
+
+      for (int n = 0; n < number_of_nodes; n++)
+	{
+	  if (cost[n] == inf)
+	    return false;
+
+	  hops[n][dst] = nhops[n];
+	  if (n == dst)
+	    {
+	      next_hop[n][dst] = dst;
+	      continue;
+	    }
+
+	  // lowest id neighbor on a shortest path
+	  for (int m : adjacency[n])
+	    if (cost[m] != inf &&
+		cost[m] + links.at(make_pair(n, m)).latency == cost[n] &&
+		nhops[m] + 1 == nhops[n] &&
+		(next_hop[n][dst] == -1 || m < next_hop[n][dst]))
+	      next_hop[n][dst] = m;
+	}
+    }
+
+  return true;
+}
+
+// ----------------------------------------------------------------------
+void Topology::computeUpDownTables()
+{
+  const long inf = numeric_limits<long>::max();
+
+  routes = ROUTES_UP_DOWN;
+  vc_classes = 1;
+
+  // BFS levels from node 0, the graph is connected
+  vector<int> level(number_of_nodes, -1);
+  queue<int> frontier;
+  level[0] = 0;
+  frontier.push(0);
+  while (!frontier.empty())
+    {
+      int n = frontier.front();
+      frontier.pop();
+      for (int m : adjacency[n])
+	if (level[m] == -1)
+	  {
+	    level[m] = level[n] + 1;
+	    frontier.push(m);
+	  }
+    }
+
+  // a hop from a to b is up if b has a lower rank
+  auto up = [&level](const int a, const int b) {
+    return make_pair(level[b], b) < make_pair(level[a], a);
+  };
+
+  vector<int> by_rank(number_of_nodes);
+  for (int n = 0; n < number_of_nodes; n++)
+    by_rank[n] = n;
+  sort(by_rank.begin(), by_rank.end(), [&level](const int a, const int b) {
+      return make_pair(level[a], a) < make_pair(level[b], b);
+    });
+
+  for (int dst = 0; dst < number_of_cores; dst++)
+    {
+      // Shortest paths made of down hops only, from dst backward
+      vector<long> cost(number_of_nodes, inf);
+      vector<int> nhops(number_of_nodes, 0);
+      priority_queue<pair<long,int>, vector<pair<long,int> >, greater<pair<long,int> > > pq;
+      cost[dst] = 0;
+      pq.push(make_pair(0, dst));
+      while (!pq.empty())
+	{
+	  long c = pq.top().first;
+	  int m = pq.top().second;
+	  pq.pop();
+	  if (c > cost[m])
+	    continue;
+
+	  for (int n : adjacency[m])
+	    {
+	      if (up(n, m))
+		continue;
+
+	      long cn = c + links.at(make_pair(n, m)).latency;
+	      if (cn < cost[n] || (cn == cost[n] && nhops[m] + 1 < nhops[n]))
+		{
+		  cost[n] = cn;
+		  nhops[n] = nhops[m] + 1;
+		  pq.push(make_pair(cn, n));
+		}
+	    }
+	}
+
+      vector<bool> down_only(number_of_nodes);
+      for (int n = 0; n < number_of_nodes; n++)
+	{
+	  down_only[n] = (cost[n] != inf);
+	  next_hop[n][dst] = (n == dst) ? dst : -1;
+	  vc_class[n][dst] = 0;
+	  if (n == dst || !down_only[n])
+	    continue;
+
+	  for (int m : adjacency[n])
+	    if (!up(n, m) && cost[m] != inf &&
+		cost[m] + links.at(make_pair(n, m)).latency == cost[n] &&
+		nhops[m] + 1 == nhops[n] &&
+		(next_hop[n][dst] == -1 || m < next_hop[n][dst]))
+	      next_hop[n][dst] = m;
+	}
+
+      // The other nodes go up first. The up neighbors have a lower
+      // rank and their route is already known.
+      for (int n : by_rank)
+	{
+	  if (down_only[n])
+	    continue;
+
+	  for (int m : adjacency[n])
+	    {
+	      if (!up(n, m))
+		continue;
+
+	      long cm = cost[m] + links.at(make_pair(n, m)).latency;
+	      if (cm < cost[n] || (cm == cost[n] && nhops[m] + 1 < nhops[n]))
+		{
+		  cost[n] = cm;
+		  nhops[n] = nhops[m] + 1;
+		  next_hop[n][dst] = m;
+		}
+	    }
+	}
+
+      for (int n = 0; n < number_of_nodes; n++)
+	hops[n][dst] = nhops[n];
+    }
+}
+
+// ----------------------------------------------------------------------
+bool Topology::hasCyclicDependencies() const
+{
+  // Channels are numbered by link and VC class
+  map<pair<int,int>,int> link_id;
+  for (const auto& l : links)
+    link_id.insert(make_pair(l.first, (int)link_id.size()));
+
+  auto channel = [&](const int n, const int dst) {
+    return link_id.at(make_pair(n, next_hop[n][dst])) * vc_classes + vc_class[n][dst];
+  };
+
+  // Dependencies between consecutive channels of the routes from the
+  // cores (a node already visited for dst adds nothing new)
+  int nchannels = link_id.size() * vc_classes;
+  vector<set<int> > depends(nchannels);
+  for (int dst = 0; dst < number_of_cores; dst++)
+    {
+      vector<bool> visited(number_of_nodes, false);
+      for (int src = 0; src < number_of_cores; src++)
+	for (int n = src; n != dst && !visited[n]; n = next_hop[n][dst])
+	  {
+	    visited[n] = true;
+	    int m = next_hop[n][dst];
+	    if (m != dst)
+	      depends[channel(n, dst)].insert(channel(m, dst));
+	  }
+    }
+
+  // Kahn's algorithm: the dependencies are acyclic if all the
+  // channels can be removed
+  vector<int> indegree(nchannels, 0);
+  for (const auto& d : depends)
+    for (int c : d)
+      indegree[c]++;
+
+  queue<int> ready;
+  for (int c = 0; c < nchannels; c++)
+    if (indegree[c] == 0)
+      ready.push(c);
+
+  int removed = 0;
+  while (!ready.empty())
+    {
+      int c = ready.front();
+      ready.pop();
+      removed++;
+      for (int d : depends[c])
+	if (--indegree[d] == 0)
+	  ready.push(d);
+    }
+
+  return removed < nchannels;
+}
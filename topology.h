@@ -0,0 +1,117 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: topology.h
+// Description: Declaration of the interconnection topologies of the cores
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __TOPOLOGY_H__
+#define __TOPOLOGY_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define TOPO_MESH    0
+#define TOPO_TORUS   1
+#define TOPO_RING    2
+#define TOPO_CMESH   3
+#define TOPO_CLUSTER 4
+#define TOPO_FILE    5
+
+// How the routing tables are computed (see computeRoutingTables)
+#define ROUTES_SHORTEST        0
+#define ROUTES_DIMENSION_ORDER 1
+#define ROUTES_UP_DOWN         2
+
+// Link between two nodes of the topology
+struct Link
+{
+  int width;   // bits
+  int latency; // clock cycles to traverse the link (a flit)
+};
+
+// Graph of the nodes of the interconnect. Nodes 0..number_of_cores-1
+// are the cores, the others are routers without qubits. Links are
+// bidirectional. Packets are routed through the precomputed next-hop
+// table:
+// - ROUTES_DIMENSION_ORDER (ring and torus): minimal routing, first
+//   along x and then along y, in the shorter direction (ties go to
+//   the increasing one). The hop of a packet whose remaining path in
+//   the dimension still crosses the wrap-around link (the dateline)
+//   uses VC class 0, the other hops VC class 1;
+// - ROUTES_SHORTEST: shortest path (sum of link latencies, ties
+//   broken by hops and then by node id);
+// - ROUTES_UP_DOWN: with deadlock_free, used in place of the
+//   shortest paths if their channels have cyclic dependencies. The
+//   nodes are ranked by BFS level from node 0 (ties by id) and a hop
+//   toward a lower rank is up. A packet takes the shortest path made
+//   of down hops only if there is one, otherwise the up hop with the
+//   shortest remaining route, so that it never goes up after a down
+//   hop.
+// The store and forward NoC has unbounded link queues and cannot
+// deadlock, while the wormhole NoC needs the VC classes (see
+// vc_class) and acyclic channel dependencies.
+struct Topology
+{
+  int number_of_cores;
+  int number_of_nodes;
+  vector<vector<int> > adjacency;
+  map<pair<int,int>, Link> links;
+  vector<vector<int> > next_hop; // [node][dst core]
+  vector<vector<int> > hops;     // [node][dst core]
+
+  // Sizes of the dimensions with wrap-around links (ring and torus),
+  // 0 for the other topologies
+  int torus_x, torus_y;
+
+  int routes;
+  int vc_classes; // VC classes needed by the routes
+  vector<vector<int> > vc_class; // [node][dst core] class of the next hop
+
+  Topology() : number_of_cores(0), number_of_nodes(0), torus_x(0), torus_y(0),
+	       routes(ROUTES_SHORTEST), vc_classes(1) {}
+
+  void clear(const int ncores, const int nnodes);
+
+  void addLink(const int a, const int b, const int width, const int latency);
+
+  const Link* getLink(const int a, const int b) const;
+
+  // Built-in topologies. In the concentrated mesh concentration cores
+  // are attached to each router of a mesh_x x mesh_y mesh. In the
+  // cluster topology there are mesh_x x mesh_y clusters of
+  // concentration fully connected cores, the first core of each
+  // cluster is its gateway and the gateways are fully connected by
+  // links with global_latency cycles.
+  void buildMesh(const int mesh_x, const int mesh_y, const int width, const bool wrap);
+  void buildRing(const int ncores, const int width);
+  void buildConcentratedMesh(const int mesh_x, const int mesh_y, const int concentration,
+			     const int width);
+  void buildCluster(const int nclusters, const int concentration, const int width,
+		    const int global_latency);
+
+  // Reads an edge-list YAML file: number_of_cores, number_of_routers
+  // (optional) and links, a list of [node_a, node_b] or [node_a,
+  // node_b, width, latency] (width defaults to default_width, latency
+  // to 1). Returns false in case of error.
+  bool readFromFile(const string& file_name, const int default_width);
+
+  // Computes next_hop, hops and vc_class. With deadlock_free the
+  // routes are free of cyclic channel dependencies. Returns false if
+  // the graph is not connected.
+  bool computeRoutingTables(const bool deadlock_free);
+
+  void computeDimensionOrderTables();
+  bool computeShortestPathTables();
+  void computeUpDownTables();
+
+  // Returns true if the channels (link and VC class) used by the
+  // routes between the cores have cyclic dependencies
+  bool hasCyclicDependencies() const;
+};
+
+#endif
@@ -68,6 +68,21 @@ bool getOrFail(const YAML::Node& node, const string& key, const string& file_nam
    }
 }
 
+// Same as getOrFail but for optional keys: if key is not present in
+// node, val is set to def_val and true is returned
+template <typename T>
+bool getOrDefault(const YAML::Node& node, const string& key, const string& file_name, T& val,
+		  const T& def_val)
+{
+  if (!node[key])
+    {
+      val = def_val;
+      return true;
+    }
+
+  return getOrFail<T>(node, key, file_name, val);
+}
+
 // returns a random integer between 0 and prob.size()-1 with prob(i) =
 // prob[i]
 int getRandomNumber(const vector<float> prob);
@@ -0,0 +1,234 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: wormhole.cpp
+// Description: Implementation of the flit-level wormhole model of the wired NoC
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#include <cmath>
+#include <limits>
+#include "utils.h"
+#include "noc.h"
+#include "wormhole.h"
+
+#define EJECT -2
+
+// ----------------------------------------------------------------------
+int WormholeNetwork::getInputPort(const int node, const int from)
+{
+  WRouter& router = routers[node];
+
+  auto it = router.port_of.find(from);
+  if (it != router.port_of.end())
+    return it->second;
+
+  WInputPort port;
+  port.from = from;
+  port.vcs.assign(noc.virtual_channels, WVirtualChannel());
+  router.inputs.push_back(port);
+  router.port_of[from] = router.inputs.size() - 1;
+
+  return router.inputs.size() - 1;
+}
+
+// ----------------------------------------------------------------------
+bool WormholeNetwork::step(const int node, const long cycle, long& next_event,
+			   vector<long>& latencies, int& delivered)
+{
+  WRouter& router = routers[node];
+  set<int> used_outputs;
+  bool moved = false;
+  int nports = router.inputs.size();
+
+  for (int i = 0; i < nports; i++)
+    {
+      int p = (router.rr + i) % nports;
+      int nvcs = routers[node].inputs[p].vcs.size();
+
+      for (int v = 0; v < nvcs; v++)
+	{
+	  WVirtualChannel& vc = routers[node].inputs[p].vcs[v];
+	  if (vc.buffer.empty())
+	    continue;
+
+	  WFlit flit = vc.buffer.front();
+	  if (flit.ready > cycle)
+	    {
+	      next_event = min(next_event, flit.ready);
+	      continue;
+	    }
+
+	  // route computation of the head flit
+	  if (vc.out_node == -1)
+	    vc.out_node = (node == dst_of[flit.packet]) ? EJECT :
+	      noc.routing(node, src_of[flit.packet], dst_of[flit.packet], flit.packet, nullptr);
+
+	  int out = vc.out_node;
+	  if (used_outputs.find(out) != used_outputs.end())
+	    continue; // retried next cycle, after another flit moved
+
+	  if (out == EJECT)
+	    {
+	      vc.buffer.pop_front();
+	      vc.reserved--;
+	      if (flit.tail)
+		{
+		  latencies[flit.packet] = cycle;
+		  delivered++;
+		  vc.packet = -1;
+		  vc.out_node = -1;
+		}
+	    }
+	  else
+	    {
+	      auto it_free = router.output_free.find(out);
+	      if (it_free != router.output_free.end() && it_free->second > cycle)
+		{
+		  next_event = min(next_event, it_free->second);
+		  continue;
+		}
+
+	      int dport = getInputPort(out, node);
+	      WVirtualChannel& cur = vc;
+	      vector<WVirtualChannel>& dvcs = routers[out].inputs[dport].vcs;
+
+	      // VC allocation, among the VCs of the class of the hop
+	      if (cur.out_vc == -1)
+		{
+		  int classes = noc.getVCClasses();
+		  int vc_class = noc.getVCClass(node, dst_of[flit.packet], flit.packet);
+		  for (int dv = vc_class; dv < (int)dvcs.size() && cur.out_vc == -1; dv += classes)
+		    if (dvcs[dv].packet == -1)
+		      cur.out_vc = dv;
+
+		  if (cur.out_vc == -1)
+		    continue; // no free VC
+		  dvcs[cur.out_vc].packet = flit.packet;
+		}
+
+	      // credits
+	      WVirtualChannel& dvc = dvcs[cur.out_vc];
+	      if (dvc.reserved >= noc.buffer_depth)
+		continue;
+
+	      const Link* link = noc.topology.getLink(node, out);
+	      int width = (link == nullptr) ? noc.link_width : link->width;
+	      int latency = (link == nullptr) ? 1 : link->latency;
+	      int serialization = max(1, (int)ceil((double)noc.link_width / width));
+
+	      WTransfer transfer;
+	      transfer.arrival = cycle + latency;
+	      transfer.node = out;
+	      transfer.port = dport;
+	      transfer.vc = cur.out_vc;
+	      transfer.flit = flit;
+	      transfers.push(transfer);
+
+	      dvc.reserved++;
+	      router.output_free[out] = cycle + serialization;
+
+	      cur.buffer.pop_front();
+	      cur.reserved--;
+	      if (flit.tail)
+		{
+		  cur.packet = -1;
+		  cur.out_node = -1;
+		  cur.out_vc = -1;
+		}
+	    }
+
+	  used_outputs.insert(out);
+	  moved = true;
+	  break; // one flit per input port
+	}
+    }
+
+  router.rr = (nports > 0) ? (router.rr + 1) % nports : 0;
+
+  return moved;
+}
+
+// ----------------------------------------------------------------------
+long WormholeNetwork::simulate(const ParallelCommunications& pcomms, vector<long>& latencies)
+{
+  int nnodes = max(noc.number_of_cores, noc.topology.number_of_nodes);
+  routers.assign(nnodes, WRouter());
+  for (int n = 0; n < nnodes; n++)
+    {
+      routers[n].rr = 0;
+      WInputPort injection;
+      injection.from = -1;
+      injection.vcs.assign(1, WVirtualChannel());
+      routers[n].inputs.push_back(injection);
+    }
+
+  int npackets = pcomms.size();
+  latencies.assign(npackets, 0);
+  dst_of.clear();
+  src_of.clear();
+  active.clear();
+
+  int pid = 0;
+  for (const auto& comm : pcomms)
+    {
+      int nflits = max(1, (int)ceil((double)comm.volume / noc.link_width));
+      WVirtualChannel& injection = routers[comm.src_core].inputs[0].vcs[0];
+      for (int f = 0; f < nflits; f++)
+	injection.buffer.push_back({pid, f == nflits - 1, (long)noc.router_pipeline});
+      injection.reserved += nflits;
+
+      src_of.push_back(comm.src_core);
+      dst_of.push_back(comm.dst_core);
+      active.insert(comm.src_core);
+      pid++;
+    }
+
+  long cycle = 0;
+  long last = 0;
+  int delivered = 0;
+  while (delivered < npackets)
+    {
+      // flits arriving in this cycle
+      while (!transfers.empty() && transfers.top().arrival <= cycle)
+	{
+	  WTransfer t = transfers.top();
+	  transfers.pop();
+	  t.flit.ready = t.arrival + noc.router_pipeline;
+	  routers[t.node].inputs[t.port].vcs[t.vc].buffer.push_back(t.flit);
+	  active.insert(t.node);
+	}
+
+      long next_event = numeric_limits<long>::max();
+      bool moved = false;
+      vector<int> nodes(active.begin(), active.end());
+      for (int node : nodes)
+	{
+	  moved |= step(node, cycle, next_event, latencies, delivered);
+
+	  bool empty = true;
+	  for (const auto& port : routers[node].inputs)
+	    for (const auto& vc : port.vcs)
+	      if (!vc.buffer.empty())
+		empty = false;
+	  if (empty)
+	    active.erase(node);
+	}
+
+      last = cycle;
+      if (delivered == npackets)
+	break;
+
+      if (moved)
+	next_event = cycle + 1;
+      if (!transfers.empty())
+	next_event = min(next_event, transfers.top().arrival);
+
+      if (next_event == numeric_limits<long>::max())
+	FATAL("Deadlock in the wormhole NoC (increase virtual_channels or buffer_depth)");
+
+      cycle = next_event;
+    }
+
+  return last;
+}
@@ -0,0 +1,112 @@
+// =============================================================================
+// Project: qcomm - Quantum Communication Simulator
+// File: wormhole.h
+// Description: Declaration of the flit-level wormhole model of the wired NoC
+// Author: Maurizio Palesi <maurizio.palesi@unict.it>
+// License: Apache-2.0 license (see LICENSE file for details)
+// =============================================================================
+
+#ifndef __WORMHOLE_H__
+#define __WORMHOLE_H__
+
+#include <deque>
+#include <map>
+#include <set>
+#include <queue>
+#include <vector>
+#include "communication.h"
+
+using namespace std;
+
+struct NoC;
+
+struct WFlit
+{
+  int  packet;
+  bool tail;
+  long ready; // first cycle the flit can leave the buffer
+};
+
+struct WVirtualChannel
+{
+  deque<WFlit> buffer;
+  int reserved; // flits buffered or in flight towards the VC
+  int packet;   // packet holding the VC, -1 if free
+  int out_node; // next node of the packet, -1 if not routed yet
+  int out_vc;   // VC allocated in the next node, -1 if none
+
+  WVirtualChannel() : reserved(0), packet(-1), out_node(-1), out_vc(-1) {}
+};
+
+struct WInputPort
+{
+  int from; // upstream node, -1 for the injection port
+  vector<WVirtualChannel> vcs;
+};
+
+struct WRouter
+{
+  vector<WInputPort> inputs;  // inputs[0] is the injection port
+  map<int,int>       port_of; // upstream node -> input port
+  map<int,long>      output_free; // next node -> first cycle the link is free
+  int                rr; // round robin pointer of the input ports
+};
+
+// Flit in flight on a link
+struct WTransfer
+{
+  long  arrival;
+  int   node, port, vc;
+  WFlit flit;
+
+  bool operator>(const WTransfer& other) const { return arrival > other.arrival; }
+};
+
+// Flit-level model of a wormhole NoC with virtual channels and
+// credit-based flow control. A message of volume bits is split into
+// ceil(volume/link_width) flits. A flit entering a router can leave
+// it router_pipeline cycles later. The head flit is routed by
+// NoC::routing and allocates a free VC of the next input port among
+// those of the VC class of the hop (NoC::getVCClass), which keeps the
+// channel dependencies acyclic. The other flits follow it and the
+// tail releases the VC. A flit is sent only if the downstream VC has
+// a free slot of its buffer_depth (credits are returned as soon as a
+// flit leaves a buffer). Each output link and each input port forward
+// one flit per cycle, a link narrower than link_width needs
+// ceil(link_width/width) cycles per flit. Sources inject their
+// messages in order through an unbounded injection queue and each
+// router ejects one flit per cycle.
+//
+// Only the routers holding flits are visited, and when no flit can
+// move the clock jumps to the next event (a flit arrival, a flit
+// leaving the pipeline or a link becoming free).
+//
+// With router_pipeline 0, link latency 1 and single flit messages
+// the latency of an isolated message is the number of hops, as in
+// the store-and-forward model.
+struct WormholeNetwork
+{
+  const NoC& noc;
+
+  vector<WRouter> routers;
+  set<int>        active; // routers holding flits
+  priority_queue<WTransfer, vector<WTransfer>, greater<WTransfer> > transfers;
+  vector<int>     dst_of; // packet -> destination core
+  vector<int>     src_of; // packet -> source core
+
+  WormholeNetwork(const NoC& noc_ref) : noc(noc_ref) {}
+
+  // Returns the cycle the last message is delivered. latencies[i] is
+  // set to the latency of the i-th message of pcomms.
+  long simulate(const ParallelCommunications& pcomms, vector<long>& latencies);
+
+  int getInputPort(const int node, const int from);
+
+  // Forwards at most one flit per input port of router node. Returns
+  // true if at least one flit moved, next_event is lowered to the
+  // first cycle a blocked flit might move without other flits moving.
+  bool step(const int node, const long cycle, long& next_event,
+	    vector<long>& latencies, int& delivered);
+};
+
+#endif